@@ -6,5 +6,9 @@ namespace Motion
 {
 
 Path dijkstraShortestPath(int source, int destination, const Graph& graph);
+std::vector<size_t> dijkstraShortestPathIndexes(int source, int destination, const Graph& graph);
+// One search from the source, an empty path for unreachable destinations.
+std::vector<std::vector<size_t>> dijkstraShortestPathsIndexes(int source, const std::vector<size_t>& destinations,
+                                                              const Graph& graph);
 
 }  // namespace Motion
\ No newline at end of file
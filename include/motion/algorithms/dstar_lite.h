@@ -0,0 +1,66 @@
+#pragma once
+
+#include "motion/algorithms/find_methods/find_method.h"
+
+#include <QPointF>
+
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace Motion
+{
+
+// D* Lite on an undirected graph with Euclidean edge costs. The search
+// runs backwards from the goals, so after the start moves, the goals
+// change or the edges of some vertices change only the affected part of
+// the previous search is repaired. Every goal has a cost of its own that
+// is added to the paths ending there, the path found leads to the goal
+// with the least total.
+class DStarLite
+{
+public:
+    DStarLite(const std::vector<QPointF>& vertices,
+              const std::vector<std::vector<size_t>>& adjacencyList);
+
+    // Appends an isolated vertex and returns its index.
+    size_t addVertex(const QPointF& point);
+    // Moves the vertex and replaces its edges, an empty list isolates it.
+    void updateVertex(size_t vertex, const QPointF& point, const std::vector<size_t>& neighbours);
+    // Replaces the goals by the given vertices and their costs.
+    void setGoals(const std::vector<std::pair<size_t, qreal>>& goals);
+    // Indexes of a shortest path from the start to one of the goals, empty
+    // if none. A cancelled or expired search keeps its progress, the next
+    // call continues it.
+    FindStatus findPath(size_t start, Deadline deadline, const CancellationToken& token,
+                        std::vector<size_t>& path);
+
+    const std::vector<QPointF>& getVertices() const { return m_vertices; }
+    const std::vector<std::vector<size_t>>& getAdjacencyList() const { return m_adjacencyList; }
+    size_t degree(size_t vertex) const { return m_adjacencyList[vertex].size(); }
+private:
+    typedef std::pair<qreal, qreal> Key;
+
+    qreal cost(size_t from, size_t to) const;
+    qreal heuristic(size_t vertex) const;
+    Key calculateKey(size_t vertex) const;
+    void updateRhs(size_t vertex);
+    FindStatus computeShortestPath(Deadline deadline, const CancellationToken& token);
+private:
+    std::vector<QPointF> m_vertices;
+    std::vector<std::vector<size_t>> m_adjacencyList;
+    std::vector<qreal> m_g;
+    std::vector<qreal> m_rhs;
+    std::vector<Key> m_keys;
+    std::vector<bool> m_queued;
+    // infinite for the vertices that are not goals
+    std::vector<qreal> m_goalCosts;
+    std::vector<size_t> m_goals;
+    std::set<std::pair<Key, size_t>> m_queue;
+    size_t m_start = 0;
+    bool m_bStarted = false;
+    QPointF m_lastStart;
+    qreal m_km = 0;
+};
+
+}  // namespace Motion
\ No newline at end of file
@@ -1,30 +1,162 @@
 #pragma once
 
 #include <QPointF>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
 #include <vector>
 
 class QGraphicsPathItem;
+class QRectF;
 
 namespace Motion
 {
 
 class Polygon;
 class PolygonSet;
+class DistanceField;
 
 typedef std::vector<QPointF> Path;
 
 inline const Path INVALID_PATH = { {-1, -1} };
 
+typedef std::chrono::steady_clock::time_point Deadline;
+
+// Tells whether a point may be used by the search, e.g. whether it lies
+// in the explored part of the scene.
+typedef std::function<bool(const QPointF&)> MaskPredicate;
+
+enum class FindStatus
+{
+    Found,      // search completed
+    Expired,    // deadline reached, path is the best found so far (may be empty)
+    NotFound,   // search completed without a path
+    Cancelled   // search was stopped through its cancellation token
+};
+
+struct FindResult
+{
+    Path path;
+    FindStatus status;
+};
+
+// Copies share the same state, so a token handed to a running search
+// can be cancelled from another thread.
+class CancellationToken
+{
+public:
+    CancellationToken() : m_pCancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() { *m_pCancelled = true; }
+    bool isCancelled() const { return *m_pCancelled; }
+private:
+    std::shared_ptr<std::atomic<bool>> m_pCancelled;
+};
+
+// Default arguments are supplied by the non-virtual overloads, the
+// virtual functions always receive every argument.
 struct IFindMethod
 {
+    virtual ~IFindMethod() {}
+
+    // Independent copy for concurrent queries; preprocessing done before
+    // the copy is shared by it.
+    virtual std::unique_ptr<IFindMethod> clone() const = 0;
+
+    // Builds whatever the queries reuse for these obstacles, e.g. a
+    // roadmap. Returns false if it was cancelled.
+    virtual bool preprocess(const PolygonSet& obstacles, const CancellationToken& token)
+    {
+        return true;
+    }
+
+    bool preprocess(const PolygonSet& obstacles)
+    {
+        return preprocess(obstacles, CancellationToken());
+    }
+
     virtual Path findPath(
         const QPointF& startPoint, 
         const QPointF& endPoint, 
-        const PolygonSet& obstacles
+        const PolygonSet& obstacles,
+        const CancellationToken& token
     ) = 0;
 
+    Path findPath(const QPointF& startPoint, const QPointF& endPoint, const PolygonSet& obstacles)
+    {
+        return findPath(startPoint, endPoint, obstacles, CancellationToken());
+    }
+
+    // Anytime query: stops once the deadline is reached and returns
+    // the best path found so far.
+    virtual FindResult findPath(
+        const QPointF& startPoint,
+        const QPointF& endPoint,
+        const PolygonSet& obstacles,
+        Deadline deadline,
+        const CancellationToken& token
+    ) = 0;
+
+    FindResult findPath(const QPointF& startPoint, const QPointF& endPoint,
+                        const PolygonSet& obstacles, Deadline deadline)
+    {
+        return findPath(startPoint, endPoint, obstacles, deadline, CancellationToken());
+    }
+
+    // Paths from one start point to each of the end points, empty where
+    // none was found. By default the queries run concurrently on clones.
+    virtual std::vector<Path> findPaths(
+        const QPointF& startPoint,
+        const std::vector<QPointF>& endPoints,
+        const PolygonSet& obstacles,
+        const CancellationToken& token
+    );
+
+    std::vector<Path> findPaths(const QPointF& startPoint, const std::vector<QPointF>& endPoints,
+                                const PolygonSet& obstacles)
+    {
+        return findPaths(startPoint, endPoints, obstacles, CancellationToken());
+    }
+
+    // Path to the first end point, in the given order, that can be
+    // reached; index receives its position. Empty if none can be reached.
+    // By default the result of one findPaths query.
+    virtual Path findFirstPath(
+        const QPointF& startPoint,
+        const std::vector<QPointF>& endPoints,
+        const PolygonSet& obstacles,
+        const CancellationToken& token,
+        size_t& index
+    );
+
+    Path findFirstPath(const QPointF& startPoint, const std::vector<QPointF>& endPoints,
+                       const PolygonSet& obstacles, size_t& index)
+    {
+        return findFirstPath(startPoint, endPoints, obstacles, CancellationToken(), index);
+    }
+
     virtual QGraphicsPathItem* getPathMap() = 0;
-    virtual void setMask(const Polygon& polygon) = 0;
+    virtual void setMask(const MaskPredicate& mask) = 0;
+    // Clearance field of the obstacles the next queries are made against,
+    // shared with the caller; methods that have no use for it ignore it.
+    virtual void setDistanceField(std::shared_ptr<const DistanceField> pField) {}
+    // The new mask differs from the previous one only inside the revealed
+    // rectangle, where it may have grown.
+    virtual void updateMask(const MaskPredicate& mask, const QRectF& revealed)
+    {
+        setMask(mask);
+    }
 };
 
+inline Deadline deadlineAfter(std::chrono::milliseconds budget)
+{
+    return std::chrono::steady_clock::now() + budget;
+}
+
+inline bool expired(Deadline deadline)
+{
+    return std::chrono::steady_clock::now() >= deadline;
+}
+
 }  // namespace Motion
\ No newline at end of file
@@ -2,9 +2,16 @@
 
 #include "motion/structures/graph.h"
 #include "motion/structures/polygon.h"
+#include "motion/algorithms/dstar_lite.h"
 #include "motion/algorithms/find_methods/find_method.h"
 
+#include <QRectF>
+
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <set>
 
 namespace Motion
 {
@@ -12,26 +19,124 @@ namespace Motion
 class PreprocessedGraph : public IFindMethod
 {
 public:
+    using IFindMethod::preprocess;
+    using IFindMethod::findPath;
+    using IFindMethod::findPaths;
+    using IFindMethod::findFirstPath;
+
+    bool preprocess(const PolygonSet& obstacles,
+                    const CancellationToken& token) override;
+
     Path findPath(
         const QPointF& startPoint,
         const QPointF& endPoint,
-        const PolygonSet& obstacles
+        const PolygonSet& obstacles,
+        const CancellationToken& token
+    ) override;
+
+    FindResult findPath(
+        const QPointF& startPoint,
+        const QPointF& endPoint,
+        const PolygonSet& obstacles,
+        Deadline deadline,
+        const CancellationToken& token
+    ) override;
+
+    // Connects the start point once and runs one search to all end points.
+    std::vector<Path> findPaths(
+        const QPointF& startPoint,
+        const std::vector<QPointF>& endPoints,
+        const PolygonSet& obstacles,
+        const CancellationToken& token
+    ) override;
+
+    // Masked queries repair one persistent search over the masked roadmap
+    // instead of searching it again, see m_search.
+    Path findFirstPath(
+        const QPointF& startPoint,
+        const std::vector<QPointF>& endPoints,
+        const PolygonSet& obstacles,
+        const CancellationToken& token,
+        size_t& index
     ) override;
 
     QGraphicsPathItem* getPathMap() override;
-    void setMask(const Polygon& polygon) override;
+    void setMask(const MaskPredicate& mask) override;
+    void updateMask(const MaskPredicate& mask, const QRectF& revealed) override;
    protected:
-    virtual void createGraph(const PolygonSet& obstacles) = 0;
+    // Returns false if the construction was cancelled.
+    virtual bool createGraph(const PolygonSet& obstacles, const CancellationToken& token) = 0;
+    // Prunes the query copy of the roadmap before the query points are connected.
+    virtual void filterGraph(Graph& graph) {}
     void addPoint(const QPointF& point);
+    // Drops the search kept for repeated queries, e.g. when filterGraph
+    // starts to prune differently.
+    void invalidateSearch();
+private:
+    void refreshMask();
+    void prepareQueryGraph();
+    FindStatus connectPoint(size_t index, const QPointF& point, const PolygonSet& obstacles,
+                            Deadline deadline, const CancellationToken& token);
+    // Roadmap vertices a query point is joined to outside the lazy mode,
+    // vertices of degree zero are masked or filtered out.
+    FindStatus visibleNeighbours(const QPointF& point, const PolygonSet& obstacles,
+                                 const std::function<size_t(size_t)>& degree, Deadline deadline,
+                                 const CancellationToken& token, std::vector<size_t>& neighbours);
+    std::vector<size_t> nearestPoints(const QPointF& point, size_t count);
+    FindResult lazySearch(size_t startIndex, size_t endIndex, const PolygonSet& obstacles,
+                          Deadline deadline, const CancellationToken& token);
+    bool checkEdge(size_t from, size_t to, const std::vector<QPointF>& vertices,
+                   const PolygonSet& obstacles);
+    FindResult incrementalSearch(const QPointF& startPoint, const std::vector<QPointF>& endPoints,
+                                 const PolygonSet& obstacles, Deadline deadline,
+                                 const CancellationToken& token, size_t& index);
 protected:
+    // Built by createGraph, then moved into the shared roadmap.
     Graph m_graph;
+    // Read-only once built, so clones share it instead of copying it.
+    std::shared_ptr<const Graph> m_pRoadmap;
     Graph m_extGraph;
     bool m_bClosest = false;
     std::vector<QPointF> m_points;
     std::vector<std::vector<size_t>> m_indexes;
     std::vector<std::pair<size_t, QPointF>> m_specialPoints;
-    std::optional<Polygon> m_mask;
-    size_t m_nObstacleCount = 0;
+    MaskPredicate m_mask;
+    // rebuilds are detected by a hash of the obstacle boundaries
+    size_t m_obstacleHash = 0;
+
+    // Mask flags of the roadmap vertices. Masked out vertices are kept in
+    // grid cells, so a revealed rectangle only tests the ones in its cells.
+    std::vector<bool> m_explored;
+    std::vector<std::vector<size_t>> m_unexploredCells;
+    QRectF m_maskBounds;
+    int m_nMaskColumns = 0;
+    int m_nMaskRows = 0;
+    QRectF m_revealed;
+    bool m_bMaskValid = false;
+
+    // Masked queries share one D* Lite search over the masked roadmap, from
+    // the start to whichever end point comes first. The query points take
+    // the slots after the roadmap vertices, so a query updates only these
+    // slots and the vertices revealed since the previous one.
+    std::optional<DStarLite> m_search;
+    std::vector<std::vector<size_t>> m_filteredAdjacency;
+    std::vector<size_t> m_querySlots;
+    std::vector<size_t> m_revealedVertices;
+
+    // Lazy mode: roadmap edges are stored unchecked and validated only
+    // when they appear on a candidate shortest path. The results are
+    // shared with the clones, so an edge checked by one query is known
+    // to every other query on the same roadmap.
+    struct LazyEdges
+    {
+        std::mutex mutex;
+        std::set<std::pair<size_t, size_t>> valid;
+        std::set<std::pair<size_t, size_t>> blocked;
+    };
+
+    bool m_bLazy = false;
+    size_t m_nLazyNeighbours = 10;
+    std::shared_ptr<LazyEdges> m_pLazyEdges = std::make_shared<LazyEdges>();
 };
 
 }  // namespace Motion
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "motion/algorithms/find_methods/preprocessed_graph.h"
+
+#include <random>
+
+namespace Motion
+{
+
+class ProbabilisticRoadmap : public PreprocessedGraph
+{
+public:
+    ProbabilisticRoadmap(int nWidth, int nHeight, int nSamples = 1000, int nNeighbours = 10);
+
+    std::unique_ptr<IFindMethod> clone() const override
+    {
+        // clones run concurrently and draw their own samples
+        auto pClone = std::make_unique<ProbabilisticRoadmap>(*this);
+        pClone->m_random.seed(std::random_device()());
+        return pClone;
+    }
+private:
+    bool createGraph(const PolygonSet& obstacles, const CancellationToken& token) override;
+private:
+    int m_nSamples;
+    int m_nNeighbours;
+    int m_nWidth;
+    int m_nHeight;
+    std::mt19937 m_random;
+};
+
+}  // namespace Motion
\ No newline at end of file
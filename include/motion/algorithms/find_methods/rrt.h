@@ -1,8 +1,12 @@
 #pragma once
 
+#include "motion/structures/distance_field.h"
 #include "motion/structures/graph.h"
 #include "motion/algorithms/find_methods/find_method.h"
 
+#include <memory>
+#include <random>
+
 namespace Motion
 {
 
@@ -13,18 +17,42 @@ public:
         int nMaxIterations=10000, int nMaxDistance=50,
         double biasProb = 0.05);
 
+    using IFindMethod::findPath;
+
+    std::unique_ptr<IFindMethod> clone() const override
+    {
+        // clones run concurrently and draw their own samples
+        auto pClone = std::make_unique<RRT>(*this);
+        pClone->m_random.seed(std::random_device()());
+        return pClone;
+    }
+
     Path findPath(
         const QPointF& startPoint,
         const QPointF& endPoint,
-        const PolygonSet& obstacles
+        const PolygonSet& obstacles,
+        const CancellationToken& token
+    ) override;
+
+    FindResult findPath(
+        const QPointF& startPoint,
+        const QPointF& endPoint,
+        const PolygonSet& obstacles,
+        Deadline deadline,
+        const CancellationToken& token
     ) override;
 
     QGraphicsPathItem* getPathMap() override;
 
-    void setMask(const Polygon& polygon) override;
+    void setMask(const MaskPredicate& mask) override;
+    void setDistanceField(std::shared_ptr<const DistanceField> pField) override;
 
 private:
+    Path growTree(const QPointF& startPoint, const QPointF& endPoint,
+                  const PolygonSet& obstacles, Deadline deadline,
+                  const CancellationToken& token, int& nIterations);
     QPointF generatePoint(const QPointF& end);
+    QPointF generateInformedPoint();
     QPointF cropLine(const QPointF& start, const QPointF& end);
 private:
     double m_biasProb;
@@ -33,7 +61,19 @@ private:
     int m_nWidth;
     int m_nHeight;
 
+    // Informed sampling state of the anytime mode: once a solution is
+    // known only the ellipse with foci start/end and major axis equal to
+    // the best cost can contain a shorter path.
+    QPointF m_start;
+    QPointF m_end;
+    qreal m_bestCost = 0.0;
+
+    // edges far from the obstacles skip the exact intersection test, the
+    // field is the cached one of the configuration space
+    std::shared_ptr<const DistanceField> m_pField;
+
     Graph m_tree;
+    std::mt19937 m_random;
 };
 
 }  // namespace Motion
\ No newline at end of file
@@ -7,8 +7,15 @@ namespace Motion
 
 class VisibilityGraph : public PreprocessedGraph
 {
+public:
+    VisibilityGraph(bool bLazy = false);
+
+    std::unique_ptr<IFindMethod> clone() const override
+    {
+        return std::make_unique<VisibilityGraph>(*this);
+    }
 private:
-    void createGraph(const PolygonSet& obstacles) override;
+    bool createGraph(const PolygonSet& obstacles, const CancellationToken& token) override;
     void addPoints(const std::vector<QPointF> points, const Polygon& polygon);
 };
 
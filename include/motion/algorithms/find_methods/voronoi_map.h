@@ -2,6 +2,8 @@
 
 #include "motion/algorithms/find_methods/preprocessed_graph.h"
 
+#include <QRectF>
+
 namespace Motion
 {
 
@@ -9,12 +11,71 @@ class VoronoiMap : public PreprocessedGraph
 {
 public:
     VoronoiMap(int nWidth, int nHeight, int nPoints = 300);
+
+    std::unique_ptr<IFindMethod> clone() const override
+    {
+        return std::make_unique<VoronoiMap>(*this);
+    }
+
+    // Queries skip roadmap edges closer to the obstacles than this,
+    // the roadmap itself is not rebuilt.
+    void setMinClearance(qreal clearance);
+
+    // Splits the scene into tiles whose diagrams see the obstacles up to
+    // overlap past the tile. A rebuild recomputes only the tiles reached
+    // by obstacles that changed; stitching joins dead ends that are left
+    // at the tile borders. The constructor sets up a 4x2 tiling.
+    void setTiling(int nColumns, int nRows, qreal overlap, bool bStitch = false);
 private:
-    void createGraph(const PolygonSet& obstacles) override;
+    struct Edge
+    {
+        size_t from;
+        size_t to;
+        qreal clearance;
+    };
+
+    struct TileEdge
+    {
+        QPointF from;
+        QPointF to;
+        qreal clearance;
+    };
+
+    struct Tile
+    {
+        QRectF core;
+        QRectF reach;
+        std::vector<TileEdge> edges;
+    };
+
+    struct Outline
+    {
+        QRectF bounds;
+        std::vector<QPointF> points;
+    };
+
+    bool createGraph(const PolygonSet& obstacles, const CancellationToken& token) override;
+    void filterGraph(Graph& graph) override;
+    void layoutTiles();
+    bool buildTile(Tile& tile, const std::vector<QLineF>& sceneLines,
+                   const std::vector<Polygon>& sceneObstacles, const QRectF& obstacleBounds,
+                   double scale, const CancellationToken& token) const;
+    void assembleGraph();
+    void stitchTiles(const PolygonSet& obstacles);
 private:
     int m_nPoints;
     int m_nWidth;
     int m_nHeight;
+    qreal m_minClearance = 0;
+    std::vector<Edge> m_edges;
+
+    int m_nColumns = 1;
+    int m_nRows = 1;
+    qreal m_overlap = 0;
+    bool m_bStitch = false;
+    std::vector<Tile> m_tiles;
+    std::vector<Outline> m_outlines;
+    double m_scale = 0;
 };
 
 }  // namespace Motion
\ No newline at end of file
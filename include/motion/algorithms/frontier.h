@@ -0,0 +1,22 @@
+#pragma once
+
+#include <QPointF>
+
+#include <vector>
+
+namespace Motion
+{
+
+struct Frontier
+{
+    QPointF goal;   // border point closest to the centroid of the cluster
+    size_t size;    // number of border points in the cluster
+};
+
+// Groups border points into frontiers: two points belong to the same
+// frontier when a chain of points at most linkDistance apart joins them
+// and both lie in the same square of side maxExtent, so a long stretch of
+// border is split into several frontiers with goals of their own.
+std::vector<Frontier> clusterFrontiers(const std::vector<QPointF>& points, qreal linkDistance, qreal maxExtent);
+
+}  // namespace Motion
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "motion/structures/polygon.h"
+#include "motion/algorithms/find_methods/find_method.h"
+
+namespace Motion
+{
+
+struct ShortcutStats
+{
+    size_t nChecks = 0;
+    size_t nRemoved = 0;
+    qreal initialLength = 0.0;
+    qreal finalLength = 0.0;
+};
+
+// Greedy shortcutting (each vertex is connected to the farthest visible
+// one) followed by randomized shortcutting between points lying on the
+// path segments. Candidate shortcuts are checked in parallel batches of
+// nBatchSize, the randomized pass checks at most nRandomChecks of them.
+// A cancelled token stops between batches with the path shortened so far.
+Path shortcutPath(const Path& path, const PolygonSet& obstacles,
+                  int nRandomChecks = 64, int nBatchSize = 8,
+                  ShortcutStats* stats = nullptr,
+                  const CancellationToken& token = CancellationToken());
+
+}  // namespace Motion
\ No newline at end of file
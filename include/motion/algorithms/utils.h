@@ -6,6 +6,7 @@
 #include <QPolygonF>
 #include <QGraphicsPolygonItem>
 
+#include <cstdint>
 #include <optional>
 
 namespace Motion
@@ -21,8 +22,10 @@ QPointF affineLine2(const QPointF& source, const QPointF& destination, qreal t);
 qreal pathLength(const Path& path);
 qreal euclideanDistSqrd(const QPointF& from, const QPointF& to);
 qreal euclideanDist(const QPointF& from, const QPointF& to);
+qreal euclideanDistToSegment(const QPointF& point, const QLineF& segment);
 std::optional<QPointF> shifted(int index, const std::vector<QPointF>& points, const Polygon& polygon);
 QRectF getSceneBBox(double scale = 1.0);
 QPolygonF unclose(const QPolygonF& polygon);
+uint64_t cellKey(int64_t column, int64_t row);
 
 }  // namespace Motion
\ No newline at end of file
@@ -11,6 +11,35 @@ namespace Motion
 
 std::vector<QPolygonF> voronoiDiagram_1(const std::vector<QPointF>& sites);
 std::vector<QPointF> voronoiDiagram_2(const std::vector<QPointF>& sites);
-std::vector<QLineF> voronoiDiagram_3(const std::vector<QLineF>& lines);
+// Segment input is rounded onto the integer grid of boost::polygon after
+// multiplying by scale; a scale of 0 fits the scene into the int32 range.
+double fitVoronoiScale(const std::vector<QLineF>& lines);
+
+// Finite primary edges of the segment Voronoi diagram, every edge once,
+// indexing into the diagram vertices.
+struct VoronoiGraph
+{
+    struct Edge
+    {
+        size_t from;
+        size_t to;
+        // input segments of the two adjacent cells, -1 for cells of
+        // segment endpoints; indexes past the input are scene bounds
+        int segments[2];
+        bool bLinear;
+        // distance from the straight chord between the vertices
+        // to the sites of the two cells
+        qreal clearance;
+    };
+
+    // largest distance between an input point and its rounded position
+    qreal precision = 0;
+    std::vector<QPointF> vertices;
+    // distance to the nearest site per vertex
+    std::vector<qreal> clearances;
+    std::vector<Edge> edges;
+};
+
+VoronoiGraph voronoiGraph(const std::vector<QLineF>& lines, double scale = 0);
 
 }  // namespace Motion
\ No newline at end of file
@@ -44,6 +44,7 @@ private slots:
     void rapidlyExploringRandomTree();
     void shortestPathRoadmap();
     void voronoiMap();
+    void probabilisticRoadmap();
 
     // Generate Map
     void generateRandom();
@@ -53,6 +54,11 @@ private slots:
     // Settings
     void useSensors();
     void useSnapping();
+    void useLazyValidation();
+    void useRasterFog();
+    void useHistorySimplification();
+    void useBackgroundVision();
+    void useVoronoiClearance();
 
     // Help
     void about();
@@ -62,6 +68,7 @@ private:
     void setMenuActionsChecked(QMenu* pMenu, bool bChecked);
     void update();
     void generate(Generate* pGenerate);
+    qreal voronoiClearance();
 private:
     bool m_bUnsavedChanges;
     Ui::AppWindowClass m_ui;
@@ -1,10 +1,12 @@
 #pragma once
 
+#include "motion/structures/distance_field.h"
 #include "motion/structures/polygon.h"
 
 #include <QGraphicsItemGroup>
 #include <QGraphicsPolygonItem>
 
+#include <memory>
 #include <vector>
 
 namespace Motion
@@ -18,6 +20,9 @@ public:
     QGraphicsPolygonItem* addObstacle(const QPolygonF& obstacle);
     QPolygonFList getObstacles();
     PolygonSet getObstaclesMSums();
+    // distance field of the minkowski sums over the scene, rebuilt when
+    // the obstacles or the cell size change
+    std::shared_ptr<const DistanceField> getDistanceField(qreal cellSize = 5);
     void draw(QGraphicsItemGroup* pGroup);
     void update();
 private:
@@ -25,6 +30,7 @@ private:
 private:
     QPolygonFList m_obstacles;
     PolygonSet m_minkowskiSums;
+    std::shared_ptr<const DistanceField> m_pDistanceField;
 };
 
 }  // namespace Motion
\ No newline at end of file
@@ -66,6 +66,7 @@ public:
     void addObstacle(const QPolygonF& polygon);
     QPolygonFList getObstacles();
     PolygonSet getObstaclesMSums();
+    std::shared_ptr<const DistanceField> getDistanceField();
 
     QRectF getViewRect();
 
@@ -82,6 +83,9 @@ public:
     void displayRoadmap(bool bDisplay);
 
     void useSensors(bool bUse);
+    void useRasterFog(bool bUse);
+    void useHistorySimplification(bool bUse);
+    void useBackgroundVision(bool bUse);
     Vision* getVision();
 
     IPathFinder* getPathFinder();
@@ -126,6 +130,9 @@ private:
     Vision* m_pVision = nullptr;
 
     bool m_bUseSnapping = false;
+    bool m_bRasterFog = false;
+    bool m_bSimplifyHistory = true;
+    bool m_bBackgroundVision = true;
 };
 
 }  // namespace Motion
\ No newline at end of file
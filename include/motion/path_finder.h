@@ -1,15 +1,25 @@
 #pragma once
 
 #include "motion/algorithms/find_methods/find_method.h"
+#include "motion/algorithms/path_shortcutting.h"
 #include "motion/structures/polygon.h"
+#include "motion/structures/spatial_hash.h"
+
+#include <future>
 
 namespace Motion
 {
 
 struct IPathFinder
 {
+    virtual ~IPathFinder() {};
+
     virtual void findPath(QPoint physicCoord) = 0;
     virtual void subPathReached() {};
+    // Stops the running query without waiting for it.
+    virtual void cancel() {};
+    // Waits for the stopped queries, e.g. before the find method is replaced.
+    virtual void wait() {};
 protected:
     void displayPath(const Path& path);
 };
@@ -17,7 +27,17 @@ protected:
 class RegularPathFinder : public IPathFinder
 {
 public:
+    ~RegularPathFinder();
+
     void findPath(QPoint physicCoord) override;
+    void cancel() override;
+    void wait() override;
+private:
+    void showResult(const FindResult& result, const QPointF& destination,
+                    double elapsed, const ShortcutStats& stats);
+
+    CancellationToken m_token;
+    std::shared_future<void> m_search;
 };
 
 class VisionPathFinder : public IPathFinder
@@ -26,14 +46,17 @@ public:
     void findPath(QPoint physicCoord) override;
     void subPathReached() override;
 private:
+    static constexpr qreal VISITED_TOLERANCE = 10;
+
     bool visited(const QPointF& v);
     bool m_pathFound = false;
+    bool m_bFullMask = true;
     QPointF m_source;
     QPointF m_destination;
     PolygonSet m_obstacles;
     Path m_path;
 
-    std::vector<QPointF> m_visited = {};
+    SpatialHash m_visited = SpatialHash(VISITED_TOLERANCE);
 };
 
 }  // namespace Motion
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "motion/structures/polygon.h"
+
+#include <QLineF>
+#include <QRectF>
+
+#include <vector>
+
+namespace Motion
+{
+
+// Distances to the boundary of obstacles sampled on a square grid, outside
+// and inside the obstacles. Cells touched by an obstacle boundary count as
+// both, so the queries give lower bounds: a positive clearance or depth is
+// certain and the exact polygon tests are only needed near the boundary.
+class DistanceField
+{
+public:
+    DistanceField(const PolygonSet& obstacles, const QRectF& bounds, qreal cellSize);
+
+    // Lower bound of the distance to the obstacles, 0 when the point may be
+    // inside one or lies out of the bounds.
+    qreal clearance(const QPointF& point) const;
+    // Lower bound of the distance to the free space, 0 when the point may
+    // be outside the obstacles or lies out of the bounds.
+    qreal depth(const QPointF& point) const;
+    // Clearance outside the obstacles, minus the depth inside.
+    qreal signedDistance(const QPointF& point) const;
+
+    bool isFree(const QPointF& point) const { return clearance(point) > 0; }
+    bool isInside(const QPointF& point) const { return depth(point) > 0; }
+    // True only if the whole segment is certainly clear of the obstacles.
+    bool isFree(const QLineF& segment) const;
+
+    QRectF bounds() const { return m_bounds; }
+    qreal cellSize() const { return m_cellSize; }
+private:
+    enum Cell : char { OUTSIDE, BOUNDARY, INSIDE };
+
+    void markBoundary(const QPointF& a, const QPointF& b);
+    void fillInside(const std::vector<std::vector<QPointF>>& rings);
+    std::vector<qreal> distanceTransform(Cell empty) const;
+    qreal lowerBound(const std::vector<qreal>& distances, const QPointF& point) const;
+private:
+    QRectF m_bounds;
+    qreal m_cellSize;
+    int m_nColumns;
+    int m_nRows;
+    std::vector<char> m_cells;
+    std::vector<qreal> m_outside;
+    std::vector<qreal> m_inside;
+};
+
+}  // namespace Motion
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <QColor>
+#include <QImage>
+#include <QPolygonF>
+#include <QRectF>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class QPainter;
+
+namespace Motion
+{
+
+// Explored area as a bit-packed raster with square cells, updated by
+// filling polygons span by span. The cells are stored in square blocks
+// that also keep their frontier cells and their image, so a fill updates
+// only the cells it covers and their neighbours. Copies share the blocks
+// until one of them writes to a block.
+class ExploredGrid
+{
+public:
+    ExploredGrid(const QRectF& bounds, qreal cellSize, const QColor& unexplored);
+
+    // Marks the cells whose centers are inside the polygon.
+    void fill(const QPolygonF& polygon);
+    void clear();
+
+    bool explored(const QPointF& point) const;
+    // Centers of explored cells next to unexplored ones inside the bounds.
+    std::vector<QPointF> frontier() const;
+    // Unexplored cells in the color given on construction.
+    void draw(QPainter* pPainter) const;
+
+    QRectF bounds() const { return m_bounds; }
+    qreal cellSize() const { return m_cellSize; }
+private:
+    // one word per row of a block
+    static constexpr int BLOCK_SIZE = 64;
+
+    struct Block
+    {
+        uint64_t explored[BLOCK_SIZE] = {};
+        uint64_t frontier[BLOCK_SIZE] = {};
+        int nFrontier = 0;
+        QImage image;
+    };
+
+    bool test(int column, int row) const;
+    void setSpan(int row, int from, int to);
+    // Recomputes the frontier flags and the pixels of the cells in the rect.
+    void refresh(int columnFrom, int rowFrom, int columnTo, int rowTo);
+    // the writable block, a copy of it if another grid shares it
+    Block& block(int column, int row);
+    const Block& block(int column, int row) const;
+    QPointF center(int column, int row) const;
+private:
+    QRectF m_bounds;
+    qreal m_cellSize;
+    QColor m_unexplored;
+    int m_nColumns;
+    int m_nRows;
+    int m_nBlockColumns;
+    int m_nBlockRows;
+    std::vector<std::shared_ptr<Block>> m_blocks;
+};
+
+}  // namespace Motion
\ No newline at end of file
@@ -23,10 +23,13 @@ public:
     Graph(const std::vector<QPointF>& vertices);
     int addVertex(const QPointF& vertex);
     void addEdge(size_t from, size_t to);
+    void removeEdge(size_t from, size_t to);
     Node nearest(const QPointF& vertex);
     Path findPath(size_t startPoint, size_t endPoint);
-    void setMask(const Polygon& polygon);
+    // Removes the edges of the vertices that are not valid.
+    void setMask(const std::vector<bool>& valid);
     size_t size();
+    size_t degree(size_t index) const;
 
     std::vector<QPointF> getVertices() const;
     std::vector<std::vector<size_t>> getAdjacencyList() const;
@@ -3,6 +3,8 @@
 #include <vector>
 #include <memory>
 
+#include <QtGlobal>
+
 class QPainterPath;
 class QPolygonF;
 class QPointF;
@@ -27,6 +29,10 @@ public:
     bool inside(const QPointF& point, bool bStrict = true) const;
     bool intersects(const QLineF& line, bool bStrict = false, std::vector<QPointF>* out = nullptr) const;
     bool isSimple() const;
+    // Drops vertices that deviate from the boundary by at most the
+    // tolerance, only where that cuts area off; never grows the polygon.
+    Polygon simplified(qreal tolerance) const;
+    size_t vertexCount() const;
     bool unite(const Polygon& polygon);
     Polygon united(const Polygon& polygon) const;
     PolygonSet intersected(const Polygon& polygon) const;
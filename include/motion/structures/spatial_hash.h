@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QPointF>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Motion
+{
+
+// Points bucketed into square cells, answers whether a point lies closer
+// than the cell size to any inserted point along both axes by looking at
+// the 3x3 neighbouring cells only.
+class SpatialHash
+{
+public:
+    explicit SpatialHash(qreal cellSize);
+
+    void insert(const QPointF& point);
+    bool contains(const QPointF& point) const;
+    void clear();
+    size_t size() const { return m_nPoints; }
+private:
+    int64_t cell(qreal coordinate) const;
+    static uint64_t key(int64_t column, int64_t row);
+private:
+    qreal m_cellSize;
+    size_t m_nPoints = 0;
+    std::unordered_map<uint64_t, std::vector<QPointF>> m_cells;
+};
+
+}  // namespace Motion
\ No newline at end of file
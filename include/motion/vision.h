@@ -1,8 +1,16 @@
 #pragma once
 
+#include <QElapsedTimer>
 #include <QGraphicsItemGroup>
+#include <QImage>
+#include <QObject>
 #include "motion/structures/polygon.h"
+#include "motion/structures/explored_grid.h"
+#include "motion/algorithms/find_methods/find_method.h"
 
+#include <future>
+#include <memory>
+#include <mutex>
 #include <optional>
 
 namespace Motion
@@ -21,26 +29,77 @@ public:
     void setEnabled(bool bEnabled);
     bool getEnabled();
     void reset(std::optional<QPointF> pos = std::nullopt);
+    // Asynchronous updates are computed by a background worker, positions
+    // submitted while it is busy are coalesced to the latest one.
     void update(QPointF pos);
+    // Updates at the position before returning.
+    void flush(QPointF pos);
     void calculateBorder();
 
-    Polygon getVisionHistory() { return m_visionHistory; }
+    void setAsync(bool bAsync);
+    // Upper bound on asynchronous updates per second, 0 for no limit.
+    void setMaxUpdateRate(qreal rate);
+
+    // Keeps the explored area as a raster of cells instead of the exact
+    // vision history polygon, whose size grows with every update.
+    void setRaster(bool bRaster);
+    bool getRaster();
+
+    // Simplifies the vision history every nInterval updates, 0 disables it.
+    void setSimplification(qreal tolerance, int nInterval);
+    size_t getHistoryVertexCount() const;
+
+    bool isExplored(const QPointF& point) const;
+    // Copy of the explored area that stays valid after the vision changes.
+    MaskPredicate getExploredMask() const;
+    // Bounds of everything seen since the previous call.
+    QRectF takeRevealedBounds();
+    // Whether the explored area was simplified since the previous call,
+    // which may shrink it outside the revealed bounds as well.
+    bool takeShrunk();
+
+    Polygon getVisionHistory() const;
     std::vector<QPointF> getUnknownPoints() { return m_unknown; }
 private:
-    void calculateDark();
+    struct ObstacleIndex;
+    struct State;
+
+    std::shared_ptr<const State> state() const;
+    void publish(std::shared_ptr<const State> pState);
+    std::shared_ptr<const State> nextState(const State& state, const QPointF& pos,
+                                           qreal simplifyTolerance, int nSimplifyInterval) const;
+    void calculateDark(const State& previous, State& state) const;
+    void loadObstacles();
+    void schedule();
+    void waitForUpdate();
+    QPolygonFList obstaclesInRange(const QPointF& pos, qreal radius) const;
 
-    QPointF m_pos;
     QGraphicsItemGroup* m_pGroup = nullptr;
     QVision* m_pDrawPath = nullptr;
-    Polygon m_currentVision;
-    Polygon m_visionHistory;
     Polygon m_scene;
-    QPolygonF m_vision;
-    QPolygonFList m_dark;
+    // rings of the united obstacles, outer boundaries and holes
     QPolygonFList m_obstacles;
+    std::unique_ptr<ObstacleIndex> m_pObstacleIndex;
     std::vector<QPointF> m_known, m_unknown;
     PolygonSet m_obss;
     bool m_bEnabled = false;
+    bool m_bRaster = false;
+    qreal m_simplifyTolerance = 1;
+    int m_nSimplifyInterval = 10;
+
+    // the latest published state, replaced as a whole by every update
+    mutable std::mutex m_mutex;
+    std::shared_ptr<const State> m_pState;
+    QRectF m_revealed;
+    bool m_bShrunk = false;
+    std::unique_ptr<QObject> m_pContext;
+    std::future<void> m_update;
+    std::optional<QPointF> m_pendingPos;
+    QElapsedTimer m_sinceUpdate;
+    bool m_bUpdating = false;
+    bool m_bDeferred = false;
+    bool m_bAsync = true;
+    qreal m_maxUpdateRate = 30;
 };
 
 }  // namespace Motion
\ No newline at end of file
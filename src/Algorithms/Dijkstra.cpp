@@ -10,6 +10,25 @@ namespace Motion
 {
 
 Path dijkstraShortestPath(int source, int destination, const Graph& graph)
+{
+    std::vector<QPointF> vertices = graph.getVertices();
+
+    Path path;
+    for (size_t index : dijkstraShortestPathIndexes(source, destination, graph))
+    {
+        path.push_back(vertices[index]);
+    }
+
+    return path;
+}
+
+std::vector<size_t> dijkstraShortestPathIndexes(int source, int destination, const Graph& graph)
+{
+    return dijkstraShortestPathsIndexes(source, { static_cast<size_t>(destination) }, graph).front();
+}
+
+std::vector<std::vector<size_t>> dijkstraShortestPathsIndexes(int source, const std::vector<size_t>& destinations,
+                                                              const Graph& graph)
 {
     typedef boost::adjacency_list<boost::listS, boost::vecS, boost::directedS, boost::no_property,
                                   boost::property<boost::edge_weight_t, qreal>> graph_t;
@@ -58,24 +77,29 @@ Path dijkstraShortestPath(int source, int destination, const Graph& graph)
     delete edge_array;
     delete weights;
 
-    if (d[destination] == INT_MAX)
+    std::vector<std::vector<size_t>> paths;
+    for (size_t destination : destinations)
     {
-        return {};
-    }
+        paths.emplace_back();
+        if (d[destination] == INT_MAX)
+        {
+            continue;
+        }
 
-    Path path;
-    boost::graph_traits<graph_t>::vertex_descriptor current = destination;
+        std::vector<size_t>& path = paths.back();
+        boost::graph_traits<graph_t>::vertex_descriptor current = destination;
 
-    while (current != source)
-    {
-        path.push_back(vertices[current]);
-        current = p[current];
-    }
-    path.push_back(vertices[source]);
+        while (current != source)
+        {
+            path.push_back(current);
+            current = p[current];
+        }
+        path.push_back(source);
 
-    std::reverse(path.begin(), path.end());
+        std::reverse(path.begin(), path.end());
+    }
 
-    return path;
+    return paths;
 }
 
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <CGAL/Vector_2.h>
 
 #include <math.h>
+#include <algorithm>
 
 
 namespace Motion
@@ -85,6 +86,19 @@ qreal euclideanDist(const QPointF& from, const QPointF& to)
     return std::sqrt(euclideanDistSqrd(from, to));
 }
 
+qreal euclideanDistToSegment(const QPointF& point, const QLineF& segment)
+{
+    const QPointF d = segment.p2() - segment.p1();
+    const qreal lengthSqrd = QPointF::dotProduct(d, d);
+    if (lengthSqrd == 0)
+    {
+        return euclideanDist(point, segment.p1());
+    }
+
+    const qreal t = std::clamp(QPointF::dotProduct(point - segment.p1(), d) / lengthSqrd, 0.0, 1.0);
+    return euclideanDist(point, segment.pointAt(t));
+}
+
 std::optional<QPointF> shifted(int index, const std::vector<QPointF>& points, const Polygon& polygon)
 {
     const QPointF& a = points[index - 1 < 0 ? points.size() - 1 : index - 1];
@@ -137,4 +151,10 @@ QPolygonF unclose(const QPolygonF& polygon)
     return polygon;
 }
 
+uint64_t cellKey(int64_t column, int64_t row)
+{
+    // shifted unsigned, shifting a negative column is undefined
+    return (static_cast<uint64_t>(column) << 32) ^ static_cast<uint32_t>(row);
+}
+
 }  // namespace Motion
\ No newline at end of file
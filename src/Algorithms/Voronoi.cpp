@@ -3,6 +3,10 @@
 #include <boost/polygon/voronoi.hpp>
 #include "motion/algorithms/utils.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <unordered_set>
 
 using boost::polygon::voronoi_builder;
@@ -150,32 +154,138 @@ std::vector<QPointF> voronoiDiagramToPoints(const voronoi_diagram<double>& vd)
     return result;
 }
 
-std::vector<QLineF> voronoiDiagramToLines(const voronoi_diagram<double>& vd)
+namespace
 {
-    std::vector<QLineF> result;
 
-    for (const auto& cell : vd.cells())
+QPointF toQPointF(const Point& point)
+{
+    return QPointF(point.a, point.b);
+}
+
+int toFixed(qreal value, double scale)
+{
+    return static_cast<int>(std::llround(value * scale));
+}
+
+Segment toSegment(const QPointF& p1, const QPointF& p2, double scale)
+{
+    return Segment(toFixed(p1.x(), scale), toFixed(p1.y(), scale),
+                   toFixed(p2.x(), scale), toFixed(p2.y(), scale));
+}
+
+qreal pointSegmentDistance(const QPointF& point, const QPointF& a, const QPointF& b)
+{
+    return euclideanDistToSegment(point, QLineF(a, b));
+}
+
+qreal segmentsDistance(const QPointF& a, const QPointF& b, const QPointF& c, const QPointF& d)
+{
+    auto cross = [](const QPointF& u, const QPointF& v)
     {
-        auto edge = cell.incident_edge();
-        if (!edge) continue;
+        return u.x() * v.y() - u.y() * v.x();
+    };
 
-        do
+    const qreal c1 = cross(b - a, c - a);
+    const qreal c2 = cross(b - a, d - a);
+    const qreal c3 = cross(d - c, a - c);
+    const qreal c4 = cross(d - c, b - c);
+
+    if (((c1 > 0 && c2 < 0) || (c1 < 0 && c2 > 0)) &&
+        ((c3 > 0 && c4 < 0) || (c3 < 0 && c4 > 0)))
+    {
+        return 0;
+    }
+
+    return std::min({ pointSegmentDistance(a, c, d), pointSegmentDistance(b, c, d),
+                      pointSegmentDistance(c, a, b), pointSegmentDistance(d, a, b) });
+}
+
+// Distance from the site of the cell to the segment [a, b]; a cell holds
+// either a whole input segment or one of its endpoints.
+qreal siteDistance(const voronoi_diagram<double>::cell_type& cell,
+                   const std::vector<Segment>& segments,
+                   const QPointF& a, const QPointF& b)
+{
+    const Segment& segment = segments[cell.source_index()];
+
+    switch (cell.source_category())
+    {
+    case boost::polygon::SOURCE_CATEGORY_SEGMENT_START_POINT:
+        return pointSegmentDistance(toQPointF(segment.p0), a, b);
+    case boost::polygon::SOURCE_CATEGORY_SEGMENT_END_POINT:
+        return pointSegmentDistance(toQPointF(segment.p1), a, b);
+    default:
+        return segmentsDistance(toQPointF(segment.p0), toQPointF(segment.p1), a, b);
+    }
+}
+
+}  // namespace
+
+VoronoiGraph voronoiDiagramToGraph(const voronoi_diagram<double>& vd, const std::vector<Segment>& segments,
+                                   double scale)
+{
+    VoronoiGraph graph;
+    graph.precision = std::sqrt(0.5) / scale;
+
+    if (vd.vertices().empty())
+    {
+        return graph;
+    }
+
+    // distances are measured on the fixed-point grid of the sites
+    std::vector<QPointF> fixed;
+    fixed.reserve(vd.num_vertices());
+    graph.vertices.reserve(vd.num_vertices());
+    graph.clearances.reserve(vd.num_vertices());
+    for (const auto& vertex : vd.vertices())
+    {
+        const QPointF point(vertex.x(), vertex.y());
+        fixed.push_back(point);
+        graph.vertices.push_back(point / scale);
+        graph.clearances.push_back(siteDistance(*vertex.incident_edge()->cell(), segments, point, point) / scale);
+    }
+
+    const auto* firstVertex = &vd.vertices().front();
+
+    for (const auto& edge : vd.edges())
+    {
+        // half-edges are stored in twin pairs, take one of them;
+        // secondary edges end on the input segments themselves
+        if (edge.twin() < &edge || !edge.is_finite() || !edge.is_primary())
         {
-            auto v0 = edge->vertex0();
-            auto v1 = edge->vertex1();
-            if (v0 && v1)
-            {
-                result.push_back({ {v0->x(), v0->y()}, {v1->x(), v1->y()} });
-            }
+            continue;
+        }
 
-            edge = edge->next();
-        } while (edge != cell.incident_edge());
+        auto segment = [](const voronoi_diagram<double>::cell_type* cell)
+        {
+            return cell->contains_segment() ? static_cast<int>(cell->source_index()) : -1;
+        };
+
+        const size_t from = edge.vertex0() - firstVertex;
+        const size_t to = edge.vertex1() - firstVertex;
+
+        // the chord of a curved edge may pass closer to the sites than
+        // its endpoints do
+        const qreal clearance = std::min({
+            graph.clearances[from],
+            graph.clearances[to],
+            siteDistance(*edge.cell(), segments, fixed[from], fixed[to]) / scale,
+            siteDistance(*edge.twin()->cell(), segments, fixed[from], fixed[to]) / scale
+        });
+
+        graph.edges.push_back({
+            from,
+            to,
+            { segment(edge.cell()), segment(edge.twin()->cell()) },
+            edge.is_linear(),
+            clearance
+        });
     }
 
-    return result;
+    return graph;
 }
 
-void pushBounds(std::vector<Segment>& segments)
+void pushBounds(std::vector<Segment>& segments, double scale = 1.0)
 {
     auto bbox = getSceneBBox();
     auto tl = bbox.topLeft();
@@ -183,10 +293,47 @@ void pushBounds(std::vector<Segment>& segments)
     auto bl = bbox.bottomLeft();
     auto br = bbox.bottomRight();
 
-    segments.push_back(Segment(tl.x(), tl.y(), tr.x(), tr.y()));
-    segments.push_back(Segment(tr.x(), tr.y(), br.x(), br.y()));
-    segments.push_back(Segment(br.x(), br.y(), bl.x(), bl.y()));
-    segments.push_back(Segment(bl.x(), bl.y(), tl.x(), tl.y()));
+    segments.push_back(toSegment(tl, tr, scale));
+    segments.push_back(toSegment(tr, br, scale));
+    segments.push_back(toSegment(br, bl, scale));
+    segments.push_back(toSegment(bl, tl, scale));
+}
+
+std::vector<Segment> toSegments(const std::vector<QLineF>& lines, double scale)
+{
+    std::vector<Segment> segments;
+    segments.reserve(lines.size() + 4);
+
+    for (const QLineF& line : lines)
+    {
+        segments.push_back(toSegment(line.p1(), line.p2(), scale));
+    }
+
+    pushBounds(segments, scale);
+
+    return segments;
+}
+
+double fitVoronoiScale(const std::vector<QLineF>& lines)
+{
+    const QRectF bbox = getSceneBBox();
+    qreal maxAbs = std::max({ std::abs(bbox.left()), std::abs(bbox.right()),
+                              std::abs(bbox.top()), std::abs(bbox.bottom()) });
+
+    for (const QLineF& line : lines)
+    {
+        maxAbs = std::max({ maxAbs, std::abs(line.x1()), std::abs(line.y1()),
+                                    std::abs(line.x2()), std::abs(line.y2()) });
+    }
+
+    if (maxAbs == 0)
+    {
+        return 1.0;
+    }
+
+    // a power of two keeps the mapping back to scene coordinates exact
+    const double limit = std::numeric_limits<int32_t>::max() / maxAbs;
+    return std::ldexp(1.0, std::ilogb(limit));
 }
 
 std::vector<QPolygonF> voronoiDiagram_1(const std::vector<QPointF>& sites)
@@ -227,23 +374,21 @@ std::vector<QPointF> voronoiDiagram_2(const std::vector<QPointF>& sites)
     return voronoiDiagramToPoints(vd);
 }
 
-std::vector<QLineF> voronoiDiagram_3(const std::vector<QLineF>& lines)
+VoronoiGraph voronoiGraph(const std::vector<QLineF>& lines, double scale)
 {
     voronoi_diagram<double> vd;
 
-    std::vector<Point> points;
-    std::vector<Segment> segments;
-
-    for (const QLineF& line : lines)
+    if (scale <= 0)
     {
-        segments.push_back(Segment(line.p1().x(), line.p1().y(), line.p2().x(), line.p2().y()));
+        scale = fitVoronoiScale(lines);
     }
 
-    pushBounds(segments);
+    std::vector<Point> points;
+    std::vector<Segment> segments = toSegments(lines, scale);
 
     construct_voronoi(points.begin(), points.end(), segments.begin(), segments.end(), &vd);
 
-    return voronoiDiagramToLines(vd);
+    return voronoiDiagramToGraph(vd, segments, scale);
 }
 
 }  // namespace Motion
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include "motion/algorithms/dstar_lite.h"
+#include "motion/algorithms/utils.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace Motion
+{
+
+const qreal INF = std::numeric_limits<qreal>::infinity();
+// expansions between the checks of the deadline and the token
+const size_t CHECK_INTERVAL = 64;
+
+DStarLite::DStarLite(const std::vector<QPointF>& vertices,
+                     const std::vector<std::vector<size_t>>& adjacencyList) :
+    m_vertices(vertices),
+    m_adjacencyList(adjacencyList),
+    m_g(vertices.size(), INF),
+    m_rhs(vertices.size(), INF),
+    m_keys(vertices.size()),
+    m_queued(vertices.size(), false),
+    m_goalCosts(vertices.size(), INF)
+{
+
+}
+
+size_t DStarLite::addVertex(const QPointF& point)
+{
+    m_vertices.push_back(point);
+    m_adjacencyList.push_back({});
+    m_g.push_back(INF);
+    m_rhs.push_back(INF);
+    m_keys.push_back({});
+    m_queued.push_back(false);
+    m_goalCosts.push_back(INF);
+    return m_vertices.size() - 1;
+}
+
+void DStarLite::updateVertex(size_t vertex, const QPointF& point, const std::vector<size_t>& neighbours)
+{
+    // every edge of the vertex may change its cost, so both the old and
+    // the new neighbours are updated
+    std::vector<size_t> affected = m_adjacencyList[vertex];
+    for (size_t neighbour : m_adjacencyList[vertex])
+    {
+        auto& list = m_adjacencyList[neighbour];
+        list.erase(std::remove(list.begin(), list.end(), vertex), list.end());
+    }
+
+    m_vertices[vertex] = point;
+    m_adjacencyList[vertex] = neighbours;
+    for (size_t neighbour : neighbours)
+    {
+        m_adjacencyList[neighbour].push_back(vertex);
+        affected.push_back(neighbour);
+    }
+    affected.push_back(vertex);
+
+    for (size_t i : affected)
+    {
+        updateRhs(i);
+    }
+}
+
+void DStarLite::setGoals(const std::vector<std::pair<size_t, qreal>>& goals)
+{
+    std::vector<size_t> affected = m_goals;
+    for (size_t goal : m_goals)
+    {
+        m_goalCosts[goal] = INF;
+    }
+
+    m_goals.clear();
+    for (const auto& goal : goals)
+    {
+        m_goalCosts[goal.first] = goal.second;
+        m_goals.push_back(goal.first);
+        affected.push_back(goal.first);
+    }
+
+    for (size_t i : affected)
+    {
+        updateRhs(i);
+    }
+}
+
+FindStatus DStarLite::findPath(size_t start, Deadline deadline, const CancellationToken& token,
+                               std::vector<size_t>& path)
+{
+    path.clear();
+
+    // the heuristic is the distance to the start, the keys queued before
+    // it moved stay lower bounds because all new keys are raised by the
+    // distance it moved; before the first start the heuristic is zero
+    if (m_bStarted)
+    {
+        m_km += euclideanDist(m_lastStart, m_vertices[start]);
+    }
+    m_bStarted = true;
+    m_lastStart = m_vertices[start];
+    m_start = start;
+
+    const FindStatus status = computeShortestPath(deadline, token);
+    if (status != FindStatus::Found)
+    {
+        return status;
+    }
+    if (m_g[m_start] == INF)
+    {
+        return FindStatus::NotFound;
+    }
+
+    // the path ends where stopping at a goal is cheaper than going on
+    path = { m_start };
+    size_t current = m_start;
+    while (path.size() <= m_vertices.size())
+    {
+        size_t next = current;
+        qreal best = m_goalCosts[current];
+        for (size_t neighbour : m_adjacencyList[current])
+        {
+            const qreal value = cost(current, neighbour) + m_g[neighbour];
+            if (value < best)
+            {
+                best = value;
+                next = neighbour;
+            }
+        }
+        if (next == current)
+        {
+            break;
+        }
+        current = next;
+        path.push_back(current);
+    }
+
+    if (m_goalCosts[current] == INF)
+    {
+        path.clear();
+        return FindStatus::NotFound;
+    }
+    return FindStatus::Found;
+}
+
+qreal DStarLite::cost(size_t from, size_t to) const
+{
+    return euclideanDist(m_vertices[from], m_vertices[to]);
+}
+
+qreal DStarLite::heuristic(size_t vertex) const
+{
+    return m_bStarted ? euclideanDist(m_vertices[m_start], m_vertices[vertex]) : 0;
+}
+
+DStarLite::Key DStarLite::calculateKey(size_t vertex) const
+{
+    const qreal value = std::min(m_g[vertex], m_rhs[vertex]);
+    return { value + heuristic(vertex) + m_km, value };
+}
+
+void DStarLite::updateRhs(size_t vertex)
+{
+    // a goal may end the path right there at its own cost
+    qreal rhs = m_goalCosts[vertex];
+    for (size_t neighbour : m_adjacencyList[vertex])
+    {
+        rhs = std::min(rhs, cost(vertex, neighbour) + m_g[neighbour]);
+    }
+    m_rhs[vertex] = rhs;
+
+    if (m_queued[vertex])
+    {
+        m_queue.erase({ m_keys[vertex], vertex });
+        m_queued[vertex] = false;
+    }
+    if (m_g[vertex] != m_rhs[vertex])
+    {
+        m_keys[vertex] = calculateKey(vertex);
+        m_queue.insert({ m_keys[vertex], vertex });
+        m_queued[vertex] = true;
+    }
+}
+
+FindStatus DStarLite::computeShortestPath(Deadline deadline, const CancellationToken& token)
+{
+    for (size_t nExpanded = 0; !m_queue.empty() &&
+         (m_queue.begin()->first < calculateKey(m_start) || m_rhs[m_start] != m_g[m_start]); ++nExpanded)
+    {
+        // the queue stays consistent between the expansions, so the
+        // search can stop here and continue later
+        if (nExpanded % CHECK_INTERVAL == 0)
+        {
+            if (token.isCancelled())
+            {
+                return FindStatus::Cancelled;
+            }
+            if (expired(deadline))
+            {
+                return FindStatus::Expired;
+            }
+        }
+
+        const auto [oldKey, vertex] = *m_queue.begin();
+        const Key newKey = calculateKey(vertex);
+
+        if (oldKey < newKey)
+        {
+            m_queue.erase(m_queue.begin());
+            m_keys[vertex] = newKey;
+            m_queue.insert({ newKey, vertex });
+        }
+        else if (m_g[vertex] > m_rhs[vertex])
+        {
+            m_g[vertex] = m_rhs[vertex];
+            m_queue.erase(m_queue.begin());
+            m_queued[vertex] = false;
+            for (size_t neighbour : m_adjacencyList[vertex])
+            {
+                updateRhs(neighbour);
+            }
+        }
+        else
+        {
+            m_g[vertex] = INF;
+            updateRhs(vertex);
+            for (size_t neighbour : m_adjacencyList[vertex])
+            {
+                updateRhs(neighbour);
+            }
+        }
+    }
+    return FindStatus::Found;
+}
+
+}  // namespace Motion
\ No newline at end of file
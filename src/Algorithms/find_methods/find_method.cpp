@@ -0,0 +1,57 @@
+#include "motion/algorithms/find_methods/find_method.h"
+
+#include "motion/structures/polygon.h"
+
+#include <algorithm>
+#include <execution>
+#include <numeric>
+
+namespace Motion
+{
+
+std::vector<Path> IFindMethod::findPaths(const QPointF& startPoint, const std::vector<QPointF>& endPoints,
+    const PolygonSet& obstacles, const CancellationToken& token)
+{
+    std::vector<Path> paths(endPoints.size());
+    if (!preprocess(obstacles, token))
+    {
+        return paths;
+    }
+
+    // the copies share what was preprocessed, each keeps its own query state
+    std::vector<std::unique_ptr<IFindMethod>> methods;
+    for (size_t i = 0; i < endPoints.size(); ++i)
+    {
+        methods.push_back(clone());
+    }
+
+    std::vector<size_t> indexes(endPoints.size());
+    std::iota(indexes.begin(), indexes.end(), 0);
+
+    std::for_each(
+        std::execution::par,
+        indexes.begin(),
+        indexes.end(),
+        [&](size_t i)
+        {
+            paths[i] = methods[i]->findPath(startPoint, endPoints[i], obstacles, token);
+        });
+
+    return paths;
+}
+
+Path IFindMethod::findFirstPath(const QPointF& startPoint, const std::vector<QPointF>& endPoints,
+    const PolygonSet& obstacles, const CancellationToken& token, size_t& index)
+{
+    const std::vector<Path> paths = findPaths(startPoint, endPoints, obstacles, token);
+    for (index = 0; index < paths.size(); ++index)
+    {
+        if (!paths[index].empty())
+        {
+            return paths[index];
+        }
+    }
+    return {};
+}
+
+}  // namespace Motion
\ No newline at end of file
@@ -2,23 +2,91 @@
 
 #include "motion/display_view.h"
 #include "motion/algorithms/Dijkstra.h"
+#include "motion/algorithms/utils.h"
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <utility>
 #include <vector>
 
 namespace Motion
 {
 
+const qreal MASK_CELL_SIZE = 50;
+// added per rank to the end point costs, longer than any path
+const qreal GOAL_RANK_COST = 1e7;
+
+inline int maskCell(qreal coordinate, qreal origin, int nCells)
+{
+    return std::clamp(static_cast<int>(std::floor((coordinate - origin) / MASK_CELL_SIZE)), 0, nCells - 1);
+}
+
+// An obstacle added over an existing one is united with it and keeps the
+// count, so the boundaries themselves are compared.
+size_t obstacleHash(const PolygonSet& obstacles)
+{
+    size_t hash = obstacles.size();
+    auto combine = [&hash](qreal value)
+    {
+        hash ^= std::hash<qreal>()(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    };
+
+    for (const QLineF& line : obstacles.lines())
+    {
+        combine(line.x1());
+        combine(line.y1());
+        combine(line.x2());
+        combine(line.y2());
+    }
+    return hash;
+}
+
+bool PreprocessedGraph::preprocess(const PolygonSet& obstacles, const CancellationToken& token)
+{
+    const size_t hash = obstacleHash(obstacles);
+    if (m_obstacleHash != hash)
+    {
+        // A cancelled construction leaves the hash stale, so the next
+        // query rebuilds the graph.
+        if (!createGraph(obstacles, token))
+        {
+            return false;
+        }
+        // clones made for the previous roadmap keep their own copies
+        m_pRoadmap = std::make_shared<const Graph>(std::move(m_graph));
+        m_graph = Graph();
+        m_pLazyEdges = std::make_shared<LazyEdges>();
+        m_obstacleHash = hash;
+        m_bMaskValid = false;
+        m_search.reset();
+    }
+    refreshMask();
+    return true;
+}
+
 Path PreprocessedGraph::findPath(const QPointF& startPoint, const QPointF& endPoint,
-    const PolygonSet& obstacles)
+    const PolygonSet& obstacles, const CancellationToken& token)
+{
+    return findPath(startPoint, endPoint, obstacles, Deadline::max(), token).path;
+}
+
+FindResult PreprocessedGraph::findPath(const QPointF& startPoint, const QPointF& endPoint,
+    const PolygonSet& obstacles, Deadline deadline, const CancellationToken& token)
 {
-    if (m_nObstacleCount != obstacles.size())
+    if (!preprocess(obstacles, token))
     {
-        createGraph(obstacles);
+        return { {}, FindStatus::Cancelled };
     }
 
-    m_extGraph = m_graph;
-    if (m_mask)
-        m_extGraph.setMask(*m_mask);
+    if (m_mask && !m_bLazy)
+    {
+        size_t index = 0;
+        return incrementalSearch(startPoint, { endPoint }, obstacles, deadline, token, index);
+    }
+
+    prepareQueryGraph();
 
     const size_t startIndex = m_extGraph.addVertex(startPoint);
     const size_t endIndex = m_extGraph.addVertex(endPoint);
@@ -26,12 +94,12 @@ Path PreprocessedGraph::findPath(const QPointF& startPoint, const QPointF& endPo
 
     if (!obstacles.intersects({ startPoint, endPoint }, true))
     {
-        return { startPoint, endPoint };
+        return { { startPoint, endPoint }, FindStatus::Found };
     }
 
     if (obstacles.inside(startPoint))
     {
-        return INVALID_PATH;
+        return { INVALID_PATH, FindStatus::NotFound };
     }
 
     m_specialPoints.clear();
@@ -39,49 +107,536 @@ Path PreprocessedGraph::findPath(const QPointF& startPoint, const QPointF& endPo
     m_specialPoints.push_back({ startIndex, startPoint });
     m_specialPoints.push_back({ endIndex, endPoint });
 
-    if (!m_bClosest)
+    for (const auto& pair : m_specialPoints)
+    {
+        const FindStatus status = connectPoint(pair.first, pair.second, obstacles, deadline, token);
+        if (status != FindStatus::Found)
+        {
+            return { {}, status };
+        }
+    }
+
+    if (m_bLazy)
+    {
+        return lazySearch(startIndex, endIndex, obstacles, deadline, token);
+    }
+
+    Path path = dijkstraShortestPath(startIndex, endIndex, m_extGraph);
+    return { path, path.empty() ? FindStatus::NotFound : FindStatus::Found };
+}
+
+std::vector<Path> PreprocessedGraph::findPaths(const QPointF& startPoint, const std::vector<QPointF>& endPoints,
+    const PolygonSet& obstacles, const CancellationToken& token)
+{
+    // lazy searches repair the roadmap along each candidate path
+    if (m_bLazy)
+    {
+        return IFindMethod::findPaths(startPoint, endPoints, obstacles, token);
+    }
+
+    std::vector<Path> paths(endPoints.size());
+    if (!preprocess(obstacles, token))
+    {
+        return paths;
+    }
+
+    prepareQueryGraph();
+
+    m_specialPoints.clear();
+    m_specialPoints.push_back({ m_extGraph.addVertex(startPoint), startPoint });
+
+    std::vector<size_t> endIndexes;
+    for (const auto& endPoint : endPoints)
+    {
+        endIndexes.push_back(m_extGraph.addVertex(endPoint));
+        m_specialPoints.push_back({ endIndexes.back(), endPoint });
+    }
+
+    const bool bStartInside = obstacles.inside(startPoint);
+    if (!bStartInside)
     {
         for (const auto& pair : m_specialPoints)
         {
-            for (int i = 0; i < m_points.size(); ++i)
+            if (connectPoint(pair.first, pair.second, obstacles, Deadline::max(), token) != FindStatus::Found)
             {
-                QLineF line(pair.second, m_points[i]);
-                if (!obstacles.intersects(line, true))
+                return paths;
+            }
+        }
+    }
+
+    const std::vector<QPointF> vertices = m_extGraph.getVertices();
+    const auto indexPaths = dijkstraShortestPathsIndexes(m_specialPoints.front().first, endIndexes, m_extGraph);
+    for (size_t i = 0; i < endPoints.size(); ++i)
+    {
+        if (!obstacles.intersects({ startPoint, endPoints[i] }, true))
+        {
+            paths[i] = { startPoint, endPoints[i] };
+        }
+        else if (bStartInside)
+        {
+            paths[i] = INVALID_PATH;
+        }
+        else
+        {
+            for (size_t index : indexPaths[i])
+            {
+                paths[i].push_back(vertices[index]);
+            }
+        }
+    }
+
+    return paths;
+}
+
+void PreprocessedGraph::refreshMask()
+{
+    if (!m_mask)
+    {
+        return;
+    }
+
+    if (!m_bMaskValid)
+    {
+        qreal left = 0, top = 0, right = 0, bottom = 0;
+        for (size_t i = 0; i < m_points.size(); ++i)
+        {
+            const QPointF& point = m_points[i];
+            left = i == 0 ? point.x() : std::min(left, point.x());
+            top = i == 0 ? point.y() : std::min(top, point.y());
+            right = i == 0 ? point.x() : std::max(right, point.x());
+            bottom = i == 0 ? point.y() : std::max(bottom, point.y());
+        }
+        m_maskBounds = QRectF(QPointF(left, top), QPointF(right, bottom));
+        m_nMaskColumns = std::max(1, static_cast<int>(std::ceil(m_maskBounds.width() / MASK_CELL_SIZE)));
+        m_nMaskRows = std::max(1, static_cast<int>(std::ceil(m_maskBounds.height() / MASK_CELL_SIZE)));
+
+        m_explored.assign(m_points.size(), false);
+        m_unexploredCells.assign(static_cast<size_t>(m_nMaskColumns) * m_nMaskRows, {});
+        for (size_t i = 0; i < m_points.size(); ++i)
+        {
+            if (m_mask(m_points[i]))
+            {
+                m_explored[i] = true;
+            }
+            else
+            {
+                m_unexploredCells[maskCell(m_points[i].y(), m_maskBounds.top(), m_nMaskRows) * m_nMaskColumns +
+                                  maskCell(m_points[i].x(), m_maskBounds.left(), m_nMaskColumns)].push_back(i);
+            }
+        }
+
+        m_bMaskValid = true;
+        m_revealed = QRectF();
+        m_search.reset();
+        return;
+    }
+
+    if (m_revealed.isNull())
+    {
+        return;
+    }
+
+    const int columnFrom = maskCell(m_revealed.left(), m_maskBounds.left(), m_nMaskColumns);
+    const int columnTo = maskCell(m_revealed.right(), m_maskBounds.left(), m_nMaskColumns);
+    const int rowFrom = maskCell(m_revealed.top(), m_maskBounds.top(), m_nMaskRows);
+    const int rowTo = maskCell(m_revealed.bottom(), m_maskBounds.top(), m_nMaskRows);
+    for (int row = rowFrom; row <= rowTo; ++row)
+    {
+        for (int column = columnFrom; column <= columnTo; ++column)
+        {
+            auto& cell = m_unexploredCells[static_cast<size_t>(row) * m_nMaskColumns + column];
+            cell.erase(std::remove_if(cell.begin(), cell.end(), [&](size_t i)
+                {
+                    if (!m_revealed.contains(m_points[i]) || !m_mask(m_points[i]))
+                        return false;
+                    m_explored[i] = true;
+                    // a search built later reads the flags themselves
+                    if (m_search)
+                        m_revealedVertices.push_back(i);
+                    return true;
+                }), cell.end());
+        }
+    }
+    m_revealed = QRectF();
+}
+
+Path PreprocessedGraph::findFirstPath(const QPointF& startPoint, const std::vector<QPointF>& endPoints,
+    const PolygonSet& obstacles, const CancellationToken& token, size_t& index)
+{
+    if (!m_mask || m_bLazy)
+    {
+        return IFindMethod::findFirstPath(startPoint, endPoints, obstacles, token, index);
+    }
+
+    index = 0;
+    if (endPoints.empty() || !preprocess(obstacles, token))
+    {
+        return {};
+    }
+
+    return incrementalSearch(startPoint, endPoints, obstacles, Deadline::max(), token, index).path;
+}
+
+FindResult PreprocessedGraph::incrementalSearch(const QPointF& startPoint, const std::vector<QPointF>& endPoints,
+    const PolygonSet& obstacles, Deadline deadline, const CancellationToken& token, size_t& index)
+{
+    if (obstacles.inside(startPoint))
+    {
+        return { INVALID_PATH, FindStatus::NotFound };
+    }
+
+    if (!m_search)
+    {
+        // the only full pass over the roadmap until the next rebuild,
+        // remask or filter change
+        Graph filtered = m_pRoadmap ? *m_pRoadmap : Graph();
+        filterGraph(filtered);
+        m_filteredAdjacency = filtered.getAdjacencyList();
+
+        std::vector<std::vector<size_t>> adjacencyList(m_points.size());
+        for (size_t i = 0; i < m_points.size(); ++i)
+        {
+            if (!m_explored[i])
+            {
+                continue;
+            }
+            for (size_t j : m_filteredAdjacency[i])
+            {
+                if (m_explored[j])
                 {
-                    m_extGraph.addEdge(pair.first, i);
+                    adjacencyList[i].push_back(j);
                 }
             }
         }
+
+        m_search.emplace(m_points, adjacencyList);
+        m_querySlots.clear();
+        m_revealedVertices.clear();
+    }
+
+    for (size_t i : m_revealedVertices)
+    {
+        std::vector<size_t> neighbours;
+        for (size_t j : m_filteredAdjacency[i])
+        {
+            if (m_explored[j])
+            {
+                neighbours.push_back(j);
+            }
+        }
+        m_search->updateVertex(i, m_points[i], neighbours);
+    }
+    m_revealedVertices.clear();
+
+    // the first slot is the start, the end points follow in order
+    while (m_querySlots.size() < endPoints.size() + 1)
+    {
+        m_querySlots.push_back(m_search->addVertex(startPoint));
+    }
+
+    auto degree = [this](size_t i) { return m_search->degree(i); };
+
+    // the end points are joined first, joining a slot drops its old edges
+    std::vector<std::pair<size_t, qreal>> goals;
+    std::vector<size_t> startNeighbours;
+    for (size_t i = 0; i < endPoints.size(); ++i)
+    {
+        const size_t slot = m_querySlots[i + 1];
+
+        std::vector<size_t> neighbours;
+        const FindStatus status = visibleNeighbours(endPoints[i], obstacles, degree, deadline, token, neighbours);
+        if (status != FindStatus::Found)
+        {
+            return { {}, status };
+        }
+        m_search->updateVertex(slot, endPoints[i], neighbours);
+
+        // an end point ranked lower is reached only when no higher ranked
+        // one can be, whatever the path lengths
+        goals.push_back({ slot, i * GOAL_RANK_COST });
+
+        if (!obstacles.intersects({ startPoint, endPoints[i] }, true))
+        {
+            startNeighbours.push_back(slot);
+        }
+    }
+
+    for (size_t i = endPoints.size() + 1; i < m_querySlots.size(); ++i)
+    {
+        m_search->updateVertex(m_querySlots[i], startPoint, {});
+    }
+
+    const FindStatus status = visibleNeighbours(startPoint, obstacles, degree, deadline, token, startNeighbours);
+    if (status != FindStatus::Found)
+    {
+        return { {}, status };
+    }
+    m_search->updateVertex(m_querySlots.front(), startPoint, startNeighbours);
+    m_search->setGoals(goals);
+
+    std::vector<size_t> indexes;
+    const FindStatus searchStatus = m_search->findPath(m_querySlots.front(), deadline, token, indexes);
+    if (searchStatus != FindStatus::Found)
+    {
+        return { {}, searchStatus };
+    }
+
+    index = std::find(m_querySlots.begin(), m_querySlots.end(), indexes.back()) - m_querySlots.begin() - 1;
+
+    const std::vector<QPointF>& vertices = m_search->getVertices();
+    Path path;
+    for (size_t i : indexes)
+    {
+        path.push_back(vertices[i]);
+    }
+    return { path, FindStatus::Found };
+}
+
+void PreprocessedGraph::invalidateSearch()
+{
+    m_search.reset();
+}
+
+void PreprocessedGraph::prepareQueryGraph()
+{
+    // nothing is built while there are no obstacles
+    m_extGraph = m_pRoadmap ? *m_pRoadmap : Graph();
+    if (m_bLazy)
+    {
+        std::lock_guard<std::mutex> lock(m_pLazyEdges->mutex);
+        for (const auto& edge : m_pLazyEdges->blocked)
+            m_extGraph.removeEdge(edge.first, edge.second);
+    }
+    if (m_mask)
+        m_extGraph.setMask(m_explored);
+    filterGraph(m_extGraph);
+}
+
+// Adds the edges between a query point of the query graph and the roadmap.
+FindStatus PreprocessedGraph::connectPoint(size_t index, const QPointF& point,
+    const PolygonSet& obstacles, Deadline deadline, const CancellationToken& token)
+{
+    std::vector<size_t> neighbours;
+    if (m_bLazy)
+    {
+        neighbours = nearestPoints(point, m_nLazyNeighbours);
     }
     else
     {
-        for (const auto& pair : m_specialPoints)
+        auto degree = [this](size_t i) { return m_extGraph.degree(i); };
+        const FindStatus status = visibleNeighbours(point, obstacles, degree, deadline, token, neighbours);
+        if (status != FindStatus::Found)
         {
-            int minI = 0;
-            qreal minLength = QLineF(pair.second, m_points[minI]).length();
+            return status;
+        }
+    }
 
-            for (int i = 0; i < m_points.size(); ++i)
+    for (size_t i : neighbours)
+    {
+        m_extGraph.addEdge(index, i);
+    }
+    return FindStatus::Found;
+}
+
+FindStatus PreprocessedGraph::visibleNeighbours(const QPointF& point, const PolygonSet& obstacles,
+    const std::function<size_t(size_t)>& degree, Deadline deadline, const CancellationToken& token,
+    std::vector<size_t>& neighbours)
+{
+    if (!m_bClosest)
+    {
+        for (size_t i = 0; i < m_points.size(); ++i)
+        {
+            if (token.isCancelled())
             {
-                QLineF line(pair.second, m_points[i]);
-                if (!obstacles.intersects(line, true))
-                {
-                    qreal currentLength = line.length();
-                    if (currentLength < minLength)
-                    {
-                        minLength = currentLength;
-                        minI = i;
-                    }
-                }
+                return FindStatus::Cancelled;
+            }
+            if (expired(deadline))
+            {
+                return FindStatus::Expired;
+            }
+
+            QLineF line(point, m_points[i]);
+            if (!obstacles.intersects(line, true))
+            {
+                neighbours.push_back(i);
             }
-            m_extGraph.addEdge(pair.first, minI);
         }
+        return FindStatus::Found;
     }
 
-    return dijkstraShortestPath(startIndex, endIndex, m_extGraph);
+    int minI = -1;
+    qreal minLength = std::numeric_limits<qreal>::max();
+
+    for (size_t i = 0; i < m_points.size(); ++i)
+    {
+        if (token.isCancelled())
+        {
+            return FindStatus::Cancelled;
+        }
+        if (expired(deadline))
+        {
+            return FindStatus::Expired;
+        }
+
+        // vertices without edges were masked or filtered out
+        if (degree(i) == 0)
+        {
+            continue;
+        }
+
+        QLineF line(point, m_points[i]);
+        qreal currentLength = line.length();
+        if (currentLength < minLength && !obstacles.intersects(line, true))
+        {
+            minLength = currentLength;
+            minI = static_cast<int>(i);
+        }
+    }
+
+    if (minI >= 0)
+    {
+        neighbours.push_back(minI);
+    }
+    return FindStatus::Found;
+}
+
+std::vector<size_t> PreprocessedGraph::nearestPoints(const QPointF& point, size_t count)
+{
+    // masked out vertices have no edges left and are useless as entry points
+    std::vector<size_t> indexes;
+    for (size_t i = 0; i < m_points.size(); ++i)
+    {
+        if (m_extGraph.degree(i) != 0)
+        {
+            indexes.push_back(i);
+        }
+    }
+
+    count = std::min(count, indexes.size());
+    std::partial_sort(indexes.begin(), indexes.begin() + count, indexes.end(),
+        [&](size_t left, size_t right)
+        {
+            return euclideanDistSqrd(m_points[left], point) < euclideanDistSqrd(m_points[right], point);
+        });
+    indexes.resize(count);
+
+    return indexes;
+}
+
+FindResult PreprocessedGraph::lazySearch(size_t startIndex, size_t endIndex,
+    const PolygonSet& obstacles, Deadline deadline, const CancellationToken& token)
+{
+    const std::vector<QPointF> vertices = m_extGraph.getVertices();
+
+    while (true)
+    {
+        if (token.isCancelled())
+        {
+            return { {}, FindStatus::Cancelled };
+        }
+        if (expired(deadline))
+        {
+            return { {}, FindStatus::Expired };
+        }
+
+        std::vector<size_t> indexes = dijkstraShortestPathIndexes(startIndex, endIndex, m_extGraph);
+        if (indexes.empty())
+        {
+            return { {}, FindStatus::NotFound };
+        }
+
+        // blocked edges are removed and the search is repeated, the whole
+        // candidate path is checked since valid edges are cached anyway
+        bool bValid = true;
+        for (size_t i = 0; i + 1 < indexes.size(); ++i)
+        {
+            if (token.isCancelled())
+            {
+                return { {}, FindStatus::Cancelled };
+            }
+
+            if (!checkEdge(indexes[i], indexes[i + 1], vertices, obstacles))
+            {
+                bValid = false;
+            }
+        }
+
+        if (bValid)
+        {
+            Path path;
+            for (size_t index : indexes)
+            {
+                path.push_back(vertices[index]);
+            }
+            return { path, FindStatus::Found };
+        }
+    }
+}
+
+bool PreprocessedGraph::checkEdge(size_t from, size_t to, const std::vector<QPointF>& vertices,
+    const PolygonSet& obstacles)
+{
+    const std::pair<size_t, size_t> edge = std::minmax(from, to);
+
+    // edges to the query points are not part of the roadmap and not cached
+    const bool bRoadmapEdge = edge.second < m_points.size();
+
+    if (bRoadmapEdge)
+    {
+        std::lock_guard<std::mutex> lock(m_pLazyEdges->mutex);
+        if (m_pLazyEdges->valid.find(edge) != m_pLazyEdges->valid.end())
+        {
+            return true;
+        }
+        if (m_pLazyEdges->blocked.find(edge) != m_pLazyEdges->blocked.end())
+        {
+            m_extGraph.removeEdge(from, to);
+            return false;
+        }
+    }
+
+    // the intersection test runs unlocked, concurrent queries may test
+    // the same edge and record the same result
+    const bool bBlocked = obstacles.intersects(QLineF(vertices[from], vertices[to]), true);
+    if (bBlocked)
+    {
+        m_extGraph.removeEdge(from, to);
+    }
+
+    if (bRoadmapEdge)
+    {
+        std::lock_guard<std::mutex> lock(m_pLazyEdges->mutex);
+        if (bBlocked)
+        {
+            m_pLazyEdges->blocked.insert(edge);
+        }
+        else
+        {
+            m_pLazyEdges->valid.insert(edge);
+        }
+    }
+    return !bBlocked;
 }
 
 QGraphicsPathItem* PreprocessedGraph::getPathMap()
 {
+    // masked queries never fill the copied graph
+    if (m_mask && m_search)
+    {
+        Graph graph(m_search->getVertices());
+        const std::vector<std::vector<size_t>>& adjacencyList = m_search->getAdjacencyList();
+        for (size_t i = 0; i < adjacencyList.size(); ++i)
+        {
+            for (size_t j : adjacencyList[i])
+            {
+                if (i < j)
+                {
+                    graph.addEdge(i, j);
+                }
+            }
+        }
+        return graph.asGraphicsItems();
+    }
     return m_extGraph.asGraphicsItems();
 }
 
@@ -91,9 +646,16 @@ void PreprocessedGraph::addPoint(const QPointF& point)
     m_points.push_back(point);
 }
 
-void PreprocessedGraph::setMask(const Polygon& polygon)
+void PreprocessedGraph::setMask(const MaskPredicate& mask)
+{
+    m_mask = mask;
+    m_bMaskValid = false;
+}
+
+void PreprocessedGraph::updateMask(const MaskPredicate& mask, const QRectF& revealed)
 {
-    m_mask = polygon;
+    m_mask = mask;
+    m_revealed = m_revealed.united(revealed);
 }
 
 }  // namespace Motion
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "motion/algorithms/find_methods/probabilistic_roadmap.h"
+
+#include <boost/geometry/geometry.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+#include <algorithm>
+#include <set>
+
+namespace Motion
+{
+
+namespace bg = boost::geometry;
+namespace bgi = boost::geometry::index;
+
+typedef bg::model::point<qreal, 2, bg::cs::cartesian> RTreePoint;
+typedef std::pair<RTreePoint, size_t> RTreeValue;
+
+ProbabilisticRoadmap::ProbabilisticRoadmap(int nWidth, int nHeight, int nSamples, int nNeighbours)
+    : m_nSamples(nSamples), m_nNeighbours(nNeighbours), m_nWidth(nWidth), m_nHeight(nHeight),
+    m_random(static_cast<unsigned>(rand()))
+{
+    m_bLazy = true;
+    m_nLazyNeighbours = nNeighbours;
+}
+
+bool ProbabilisticRoadmap::createGraph(const PolygonSet& obstacles, const CancellationToken& token)
+{
+    m_graph = Graph();
+    m_indexes.clear();
+    m_points.clear();
+
+    // sampling is the only place where the roadmap touches the obstacles,
+    // edges are validated lazily by the queries
+    const size_t nSamples = static_cast<size_t>(std::max(m_nSamples, 0));
+    const int nMaxAttempts = m_nSamples * 10;
+    std::uniform_int_distribution<int> x(0, m_nWidth - 1);
+    std::uniform_int_distribution<int> y(0, m_nHeight - 1);
+    for (int i = 0; i < nMaxAttempts && m_points.size() < nSamples; ++i)
+    {
+        if (token.isCancelled())
+        {
+            return false;
+        }
+
+        QPointF point(x(m_random) - m_nWidth / 2,
+                      y(m_random) - m_nHeight / 2);
+
+        if (!obstacles.inside(point))
+        {
+            addPoint(point);
+        }
+    }
+
+    std::vector<RTreeValue> values;
+    values.reserve(m_points.size());
+    for (size_t i = 0; i < m_points.size(); ++i)
+    {
+        values.push_back({ RTreePoint(m_points[i].x(), m_points[i].y()), i });
+    }
+
+    bgi::rtree<RTreeValue, bgi::quadratic<16>> rtree(values.begin(), values.end());
+
+    std::set<std::pair<size_t, size_t>> edges;
+    for (size_t i = 0; i < m_points.size(); ++i)
+    {
+        std::vector<RTreeValue> neighbours;
+        rtree.query(bgi::nearest(values[i].first, m_nNeighbours + 1), std::back_inserter(neighbours));
+
+        for (const auto& neighbour : neighbours)
+        {
+            if (neighbour.second != i)
+            {
+                edges.insert(std::minmax(i, neighbour.second));
+            }
+        }
+    }
+
+    for (const auto& edge : edges)
+    {
+        m_graph.addEdge(edge.first, edge.second);
+    }
+
+    return true;
+}
+
+}  // namespace Motion
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "motion/algorithms/utils.h"
 #include <QtMath>
 
+#include <utility>
 #include <vector>
 
 namespace Motion
@@ -15,26 +16,62 @@ RRT::RRT(int nWidth, int nHeight,
     m_nHeight(nHeight),
     m_nMaxIterations(nMaxIterations),
     m_nMaxDistance(nMaxDistance),
-    m_biasProb(biasProb)
+    m_biasProb(biasProb),
+    m_random(static_cast<unsigned>(rand()))
 {
 
 }
 
 QPointF RRT::generatePoint(const QPointF& end)
 {
-    if (static_cast<double>(rand()) / RAND_MAX < m_biasProb)
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    if (unit(m_random) < m_biasProb)
     {
         return end;
     }
+    else if (m_bestCost > 0.0)
+    {
+        return generateInformedPoint();
+    }
     else
     {
-        qreal x = rand() % m_nWidth - m_nWidth / 2;
-        qreal y = rand() % m_nHeight - m_nHeight / 2;
+        qreal x = std::uniform_int_distribution<int>(0, m_nWidth - 1)(m_random) - m_nWidth / 2;
+        qreal y = std::uniform_int_distribution<int>(0, m_nHeight - 1)(m_random) - m_nHeight / 2;
 
         return { x, y };
     }
 }
 
+QPointF RRT::generateInformedPoint()
+{
+    const qreal minCost = euclideanDist(m_start, m_end);
+    const qreal a = m_bestCost / 2;
+    const qreal b = std::sqrt(std::max(0.0, m_bestCost * m_bestCost - minCost * minCost)) / 2;
+    const qreal theta = qAtan2(m_end.y() - m_start.y(), m_end.x() - m_start.x());
+    const QPointF center = (m_start + m_end) / 2;
+
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    const int nAttempts = 10;
+    for (int i = 0; i < nAttempts; ++i)
+    {
+        // uniform point of the unit disk, stretched to the ellipse
+        qreal r = std::sqrt(unit(m_random));
+        qreal phi = 2 * M_PI * unit(m_random);
+        qreal x = a * r * qCos(phi);
+        qreal y = b * r * qSin(phi);
+
+        QPointF point(center.x() + x * qCos(theta) - y * qSin(theta),
+                      center.y() + x * qSin(theta) + y * qCos(theta));
+
+        if (std::fabs(point.x()) <= m_nWidth / 2 && std::fabs(point.y()) <= m_nHeight / 2)
+        {
+            return point;
+        }
+    }
+
+    return m_end;
+}
+
 QPointF RRT::cropLine(const QPointF& start, const QPointF& end)
 {
     if (euclideanDist(start, end) < m_nMaxDistance)
@@ -50,16 +87,18 @@ QPointF RRT::cropLine(const QPointF& start, const QPointF& end)
     }
 }
 
-Path RRT::findPath(const QPointF& startPoint,
+Path RRT::growTree(const QPointF& startPoint,
                    const QPointF& endPoint,
-                   const PolygonSet& obstacles)
+                   const PolygonSet& obstacles,
+                   Deadline deadline,
+                   const CancellationToken& token,
+                   int& nIterations)
 {
     m_tree = Graph({ startPoint });
 
-    for (int i = 0; i <= m_nMaxIterations; ++i)
+    for (; nIterations < m_nMaxIterations; ++nIterations)
     {
-        assert(i != m_nMaxIterations);
-        if (i == m_nMaxIterations)
+        if (token.isCancelled() || expired(deadline))
         {
             return {};
         }
@@ -68,7 +107,15 @@ Path RRT::findPath(const QPointF& startPoint,
         Graph::Node nearestPoint = m_tree.nearest(randomPoint);
         QPointF newPoint = cropLine(nearestPoint.point, randomPoint);
 
-        if (obstacles.intersects(QLineF(nearestPoint.point, newPoint)))
+        // outside the informed set the point can't improve the solution
+        if (m_bestCost > 0.0 &&
+            euclideanDist(startPoint, newPoint) + euclideanDist(newPoint, endPoint) > m_bestCost)
+        {
+            continue;
+        }
+
+        const QLineF edge(nearestPoint.point, newPoint);
+        if ((!m_pField || !m_pField->isFree(edge)) && obstacles.intersects(edge))
         {
             continue;
         }
@@ -78,10 +125,75 @@ Path RRT::findPath(const QPointF& startPoint,
 
         if (newPoint == endPoint)
         {
-            break;
+            ++nIterations;
+            return m_tree.findPath(0, m_tree.size() - 1);
+        }
+    }
+    return {};
+}
+
+Path RRT::findPath(const QPointF& startPoint,
+                   const QPointF& endPoint,
+                   const PolygonSet& obstacles,
+                   const CancellationToken& token)
+{
+    m_bestCost = 0.0;
+
+    int nIterations = 0;
+    Path path = growTree(startPoint, endPoint, obstacles, Deadline::max(), token, nIterations);
+    assert(!path.empty() || token.isCancelled());
+    return path;
+}
+
+FindResult RRT::findPath(const QPointF& startPoint,
+                         const QPointF& endPoint,
+                         const PolygonSet& obstacles,
+                         Deadline deadline,
+                         const CancellationToken& token)
+{
+    // Anytime mode: the iteration budget is shared between restarts,
+    // every restart that reaches the goal may only improve the best path.
+    Path bestPath;
+    Graph bestTree;
+    int nIterations = 0;
+
+    m_start = startPoint;
+    m_end = endPoint;
+    m_bestCost = 0.0;
+
+    while (nIterations < m_nMaxIterations && !expired(deadline) && !token.isCancelled())
+    {
+        Path path = growTree(startPoint, endPoint, obstacles, deadline, token, nIterations);
+        if (path.empty())
+        {
+            continue;
+        }
+
+        qreal length = pathLength(path);
+        if (bestPath.empty() || length < m_bestCost)
+        {
+            bestPath = path;
+            m_bestCost = length;
+            bestTree = m_tree;
         }
     }
-    return m_tree.findPath(0, m_tree.size() - 1);
+
+    m_bestCost = 0.0;
+
+    if (!bestPath.empty())
+    {
+        m_tree = bestTree;
+    }
+
+    if (token.isCancelled())
+    {
+        return { bestPath, FindStatus::Cancelled };
+    }
+    if (expired(deadline))
+    {
+        return { bestPath, FindStatus::Expired };
+    }
+    return { bestPath, bestPath.empty() ? FindStatus::NotFound : FindStatus::Found };
 }
 
 QGraphicsPathItem* RRT::getPathMap()
@@ -89,9 +201,14 @@ QGraphicsPathItem* RRT::getPathMap()
     return m_tree.asGraphicsItems();
 }
 
-void RRT::setMask(const Polygon& polygon)
+void RRT::setMask(const MaskPredicate& mask)
 {
   // Not needed
 }
 
+void RRT::setDistanceField(std::shared_ptr<const DistanceField> pField)
+{
+    m_pField = std::move(pField);
+}
+
 }  // namespace Motion
\ No newline at end of file
@@ -2,14 +2,23 @@
 
 #include "motion/algorithms/utils.h"
 
+#include <limits>
+
 namespace Motion
 {
 
-void VisibilityGraph::createGraph(const PolygonSet& obstacles)
+VisibilityGraph::VisibilityGraph(bool bLazy)
+{
+    // every vertex is a candidate neighbour of the query points,
+    // as in the eager mode
+    m_bLazy = bLazy;
+    m_nLazyNeighbours = std::numeric_limits<size_t>::max();
+}
+
+bool VisibilityGraph::createGraph(const PolygonSet& obstacles, const CancellationToken& token)
 {
     m_graph = Graph();
     m_indexes.clear();
-    m_nObstacleCount = obstacles.size();
 
     m_points.clear();
 
@@ -25,16 +34,24 @@ void VisibilityGraph::createGraph(const PolygonSet& obstacles)
 
     for (size_t i = 0; i < m_points.size(); ++i)
     {
+        if (token.isCancelled())
+        {
+            return false;
+        }
+
         for (size_t j = i + 1; j < m_points.size(); ++j)
         {
             QLineF line(m_points[i], m_points[j]);
 
-            if (!obstacles.intersects(line, true))
+            // in lazy mode every pair is a candidate edge, validated on demand
+            if (m_bLazy || !obstacles.intersects(line, true))
             {
                 m_graph.addEdge(i, j);
             }
         }
     }
+
+    return true;
 }
 
 void VisibilityGraph::addPoints(const std::vector<QPointF> points, const Polygon& polygon)
@@ -1,118 +1,551 @@
 #include "motion/algorithms/find_methods/voronoi_map.h"
 #include "motion/algorithms/voronoi.h"
+#include "motion/algorithms/utils.h"
 
-namespace std
+#include <boost/geometry/geometry.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <optional>
+
+namespace Motion
+{
+
+namespace bg = boost::geometry;
+namespace bgi = boost::geometry::index;
+
+typedef bg::model::point<qreal, 2, bg::cs::cartesian> RTreePoint;
+typedef bg::model::box<RTreePoint> RTreeBox;
+typedef std::pair<RTreeBox, size_t> RTreeValue;
+typedef bgi::rtree<RTreeValue, bgi::quadratic<16>> RTree;
+
+namespace
+{
+
+enum Clearance { BLOCKED, FREE, UNKNOWN };
+
+RTreeBox toBox(const QRectF& rect)
 {
-    template <> struct hash<QPointF>
+    return RTreeBox(RTreePoint(rect.left(), rect.top()), RTreePoint(rect.right(), rect.bottom()));
+}
+
+// Positive on the left of the directed segment, which is the obstacle
+// side: outer boundaries are counterclockwise and holes are clockwise.
+qreal signedDistance(const QLineF& line, const QPointF& point)
+{
+    const QPointF d = line.p2() - line.p1();
+    const QPointF v = point - line.p1();
+    return (d.x() * v.y() - d.y() * v.x()) / line.length();
+}
+
+// Every point of a straight edge is nearest to the interior of the segment
+// of an adjacent cell, so its distance to the segment line changes linearly
+// and the side of the whole edge follows from the endpoints. Closer to a
+// site than the margin the rounded diagram input may disagree with the
+// real segment.
+Clearance classify(const VoronoiGraph::Edge& edge,
+                   const std::vector<QPointF>& vertices,
+                   const std::vector<QLineF>& lines,
+                   qreal margin,
+                   bool bBoundsFree)
+{
+    if (!edge.bLinear)
     {
-        inline size_t operator()(const QPointF& v) const
+        return UNKNOWN;
+    }
+
+    for (int segment : edge.segments)
+    {
+        if (segment < 0)
         {
-            std::hash<double> int_hasher;
-            return int_hasher(v.x()) ^ int_hasher(v.y());
+            continue;
         }
-    };
 
+        if (segment >= static_cast<int>(lines.size()))
+        {
+            if (bBoundsFree)
+            {
+                return FREE;
+            }
+            continue;
+        }
+
+        const QLineF& line = lines[segment];
+        if (line.length() == 0)
+        {
+            continue;
+        }
+
+        const qreal d1 = signedDistance(line, vertices[edge.from]);
+        const qreal d2 = signedDistance(line, vertices[edge.to]);
+
+        if (d1 < -margin && d2 < -margin)
+        {
+            return FREE;
+        }
+        if (d1 > margin && d2 > margin)
+        {
+            return BLOCKED;
+        }
+    }
+
+    return UNKNOWN;
 }
 
-namespace Motion
+// Vertices of neighbouring tiles closer than 1 / VERTEX_GRID are merged.
+const qreal VERTEX_GRID = 1000.0;
+
+// Default tiling: an obstacle edit rebuilds about one eighth of the scene.
+const int TILE_COLUMNS = 4;
+const int TILE_ROWS = 2;
+const qreal TILE_OVERLAP = 400;
+
+// Half-open, so a point on the border between two tiles belongs to one.
+bool insideCore(const QPointF& point, const QRectF& core)
 {
+    return point.x() >= core.left() && point.x() < core.right() &&
+           point.y() >= core.top() && point.y() < core.bottom();
+}
+
+// Liang-Barsky clipping of the line to the rect.
+std::optional<QLineF> clipped(const QLineF& line, const QRectF& rect)
+{
+    const qreal dx = line.dx();
+    const qreal dy = line.dy();
+    const qreal p[4] = { -dx, dx, -dy, dy };
+    const qreal q[4] = { line.x1() - rect.left(), rect.right() - line.x1(),
+                         line.y1() - rect.top(), rect.bottom() - line.y1() };
+
+    qreal t0 = 0;
+    qreal t1 = 1;
+    for (int i = 0; i < 4; ++i)
+    {
+        if (p[i] == 0)
+        {
+            if (q[i] < 0)
+            {
+                return std::nullopt;
+            }
+            continue;
+        }
+
+        const qreal t = q[i] / p[i];
+        if (p[i] < 0)
+        {
+            t0 = std::max(t0, t);
+        }
+        else
+        {
+            t1 = std::min(t1, t);
+        }
+    }
+
+    if (t0 > t1)
+    {
+        return std::nullopt;
+    }
+
+    return QLineF(line.pointAt(t0), line.pointAt(t1));
+}
+
+}  // namespace
 
 VoronoiMap::VoronoiMap(int nWidth, int nHeight, int nPoints)
     : m_nWidth(nWidth), m_nHeight(nHeight), m_nPoints(nPoints)
 {
     m_bClosest = true;
+    setTiling(TILE_COLUMNS, TILE_ROWS, TILE_OVERLAP, true);
 }
 
-void VoronoiMap::createGraph(const PolygonSet& obstacles)
+bool VoronoiMap::createGraph(const PolygonSet& obstacles, const CancellationToken& token)
 {
     m_graph = Graph();
     m_indexes.clear();
-    m_nObstacleCount = obstacles.size();
-
-    std::vector<QLineF> lines = voronoiDiagram_3(obstacles.lines());
+    m_points.clear();
+    m_edges.clear();
 
+    std::vector<Outline> outlines;
+    for (const auto& polygon : obstacles.getPolygons())
+    {
+        outlines.push_back({ polygon.bounds(), polygon.points() });
+        for (const auto& hole : polygon.holes())
+        {
+            outlines.back().points.insert(outlines.back().points.end(), hole.begin(), hole.end());
+        }
+    }
 
-    auto equalsDouble = [](double a, double b)
+    // bounds of the obstacles that were removed or added since the last build
+    std::vector<QRectF> changed;
+    auto collectChanged = [&changed](const std::vector<Outline>& from, const std::vector<Outline>& to)
     {
-        return std::fabs(a - b) < 1e-2;
+        for (const auto& outline : from)
+        {
+            auto same = [&outline](const Outline& other)
+            {
+                return outline.bounds == other.bounds && outline.points == other.points;
+            };
+            if (std::none_of(to.begin(), to.end(), same))
+            {
+                changed.push_back(outline.bounds);
+            }
+        }
     };
+    collectChanged(m_outlines, outlines);
+    collectChanged(outlines, m_outlines);
+
+    const std::vector<QLineF> lines = obstacles.lines();
+    const std::vector<Polygon> polygons = obstacles.getPolygons();
+    const QRectF obstacleBounds = obstacles.bounds();
+    // every tile rounds onto the same grid, so the vertices they share
+    // come out equal up to the clipping of long segments; a new grid
+    // needs every tile again
+    const double scale = fitVoronoiScale(lines);
 
-    auto equalsPoint = [equalsDouble](const QPointF& left, const QPointF& right)
+    const bool bRebuild = m_tiles.empty() || scale != m_scale;
+    if (m_tiles.empty())
     {
-        return equalsDouble(left.x(), right.x()) && equalsDouble(left.y(), right.y());
-    };
+        layoutTiles();
+    }
 
-    auto lessPoint = [equalsDouble](const QPointF& left, const QPointF& right)
+    for (auto& tile : m_tiles)
     {
-        if (equalsDouble(left.x(), right.x()))
+        auto touches = [&tile](const QRectF& rect)
         {
-            return left.y() < right.y();
+            return tile.reach.intersects(rect);
+        };
+
+        if (bRebuild || std::any_of(changed.begin(), changed.end(), touches))
+        {
+            // a cancelled build keeps the previous outlines, so the tiles
+            // are compared against them again by the next build
+            if (!buildTile(tile, lines, polygons, obstacleBounds, scale, token))
+            {
+                return false;
+            }
         }
+    }
 
-        return left.x() < right.x();
-    };
+    m_outlines = outlines;
+    m_scale = scale;
+
+    assembleGraph();
+
+    if (m_bStitch)
+    {
+        stitchTiles(obstacles);
+    }
+
+    return true;
+}
+
+void VoronoiMap::layoutTiles()
+{
+    const QRectF scene = getSceneBBox();
+    const qreal width = scene.width() / m_nColumns;
+    const qreal height = scene.height() / m_nRows;
+
+    // border tiles reach past the scene, where the configuration space
+    // obstacles stick out by the device size
+    const qreal outside = std::max(scene.width(), scene.height());
 
-    auto compareQLineF = [equalsPoint, lessPoint](const QLineF& left, const QLineF& right)
+    m_tiles.clear();
+    for (int row = 0; row < m_nRows; ++row)
     {
-        if (equalsPoint(left.p1(), right.p1()))
-            return lessPoint(left.p2(), right.p2());
-        return lessPoint(left.p1(), right.p1());
+        for (int column = 0; column < m_nColumns; ++column)
+        {
+            QRectF core(scene.left() + column * width, scene.top() + row * height, width, height);
+            core.adjust(column == 0 ? -outside : 0,
+                        row == 0 ? -outside : 0,
+                        column == m_nColumns - 1 ? outside : 0,
+                        row == m_nRows - 1 ? outside : 0);
+
+            m_tiles.push_back({ core, core.adjusted(-m_overlap, -m_overlap, m_overlap, m_overlap), {} });
+        }
+    }
+}
+
+bool VoronoiMap::buildTile(Tile& tile, const std::vector<QLineF>& sceneLines,
+    const std::vector<Polygon>& sceneObstacles, const QRectF& obstacleBounds,
+    double scale, const CancellationToken& token) const
+{
+    // sites outside the reach of the tile are dropped, the tile bounds
+    // themselves are not sites
+    std::vector<QLineF> lines;
+    for (const QLineF& line : sceneLines)
+    {
+        if (auto part = clipped(line, tile.reach))
+        {
+            lines.push_back(*part);
+        }
+    }
+
+    // edges leaving the reach are tested against obstacles the diagram
+    // did not see, so every obstacle is indexed
+    std::vector<RTreeValue> values;
+    for (size_t i = 0; i < sceneObstacles.size(); ++i)
+    {
+        values.push_back({ toBox(sceneObstacles[i].bounds()), i });
+    }
+    const RTree rtree(values.begin(), values.end());
+
+    VoronoiGraph diagram = voronoiGraph(lines, scale);
+
+    if (token.isCancelled())
+    {
+        return false;
+    }
+
+    // the diagram sites are off by up to its precision, so are the
+    // distances measured on it
+    const qreal margin = 2 * diagram.precision;
+
+    // cells of the scene bounds are free while no obstacle reaches them
+    const QRectF scene = getSceneBBox().adjusted(margin, margin, -margin, -margin);
+    const bool bBoundsFree = scene.contains(obstacleBounds);
+
+    auto blocked = [&](const QLineF& line)
+    {
+        const QPointF p1 = line.p1();
+        const QPointF p2 = line.p2();
+        const RTreeBox box(RTreePoint(std::min(p1.x(), p2.x()), std::min(p1.y(), p2.y())),
+                           RTreePoint(std::max(p1.x(), p2.x()), std::max(p1.y(), p2.y())));
+
+        for (auto it = rtree.qbegin(bgi::intersects(box)); it != rtree.qend(); ++it)
+        {
+            const Polygon& polygon = sceneObstacles[it->second];
+            if (polygon.inside(p1) || polygon.inside(p2) || polygon.intersects(line, true))
+            {
+                return true;
+            }
+        }
+        return false;
     };
 
-    for (auto& line : lines)
+    std::vector<char> accepted(diagram.edges.size());
+    std::vector<size_t> order(diagram.edges.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    std::for_each(
+        std::execution::par,
+        order.begin(),
+        order.end(),
+        [&](size_t i)
+        {
+            if (token.isCancelled())
+            {
+                return;
+            }
+
+            // every edge belongs to the one tile holding its midpoint
+            const auto& edge = diagram.edges[i];
+            const QLineF line(diagram.vertices[edge.from], diagram.vertices[edge.to]);
+            if (!insideCore(line.center(), tile.core))
+            {
+                accepted[i] = false;
+                return;
+            }
+
+            switch (classify(edge, diagram.vertices, lines, margin, bBoundsFree))
+            {
+            case FREE:
+                // free only of the sites in the reach, a longer edge may
+                // cross an obstacle beyond it
+                accepted[i] = (tile.reach.contains(line.p1()) && tile.reach.contains(line.p2())) ||
+                              !blocked(line);
+                break;
+            case BLOCKED:
+                accepted[i] = false;
+                break;
+            case UNKNOWN:
+                accepted[i] = !blocked(line);
+                break;
+            }
+        });
+
+    if (token.isCancelled())
     {
-        auto p1 = line.p1();
-        auto p2 = line.p2();
-        if (lessPoint(p1, p2))
+        return false;
+    }
+
+    tile.edges.clear();
+    for (size_t i = 0; i < diagram.edges.size(); ++i)
+    {
+        if (accepted[i])
         {
-            line.setP1(p2);
-            line.setP2(p1);
+            const auto& edge = diagram.edges[i];
+            tile.edges.push_back({ diagram.vertices[edge.from], diagram.vertices[edge.to], edge.clearance });
         }
     }
 
-    std::sort(lines.begin(), lines.end(), compareQLineF);
-    auto end = std::unique(lines.begin(), lines.end());
-    lines.erase(end, lines.end());
+    return true;
+}
 
-    m_points.clear();
-    m_points.reserve(lines.size());
+void VoronoiMap::assembleGraph()
+{
+    // neighbouring tiles compute shared vertices separately, so they are
+    // matched by position on a fine grid
+    std::map<std::pair<qint64, qint64>, size_t> indexes;
 
-    for (auto it = lines.begin(); it != lines.end(); )
+    auto index = [&](const QPointF& point)
     {
-        if (obstacles.inside(it->p1()) || obstacles.inside(it->p2()))
+        const std::pair<qint64, qint64> key(std::llround(point.x() * VERTEX_GRID),
+                                            std::llround(point.y() * VERTEX_GRID));
+
+        auto it = indexes.find(key);
+        if (it == indexes.end())
         {
-            it = lines.erase(it);
+            it = indexes.insert({ key, m_points.size() }).first;
+            addPoint(point);
         }
-        else
+        return it->second;
+    };
+
+    for (const auto& tile : m_tiles)
+    {
+        for (const auto& edge : tile.edges)
         {
-            ++it;
+            const size_t from = index(edge.from);
+            const size_t to = index(edge.to);
+
+            if (from != to)
+            {
+                m_graph.addEdge(from, to);
+                m_edges.push_back({ from, to, edge.clearance });
+            }
         }
     }
+}
+
+void VoronoiMap::stitchTiles(const PolygonSet& obstacles)
+{
+    const QRectF scene = getSceneBBox();
+
+    auto nearBorder = [&](const QPointF& point)
+    {
+        for (int column = 1; column < m_nColumns; ++column)
+        {
+            const qreal x = scene.left() + column * scene.width() / m_nColumns;
+            if (std::abs(point.x() - x) < m_overlap)
+            {
+                return true;
+            }
+        }
+        for (int row = 1; row < m_nRows; ++row)
+        {
+            const qreal y = scene.top() + row * scene.height() / m_nRows;
+            if (std::abs(point.y() - y) < m_overlap)
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    const std::vector<QLineF> lines = obstacles.lines();
+
+    // the stitch does not cross the obstacles, so its distance to them is
+    // reached at an endpoint of the stitch or of an obstacle segment
+    auto clearance = [&lines](const QLineF& stitch)
+    {
+        qreal result = std::numeric_limits<qreal>::max();
+        for (const QLineF& line : lines)
+        {
+            result = std::min({ result,
+                                euclideanDistToSegment(stitch.p1(), line),
+                                euclideanDistToSegment(stitch.p2(), line),
+                                euclideanDistToSegment(line.p1(), stitch),
+                                euclideanDistToSegment(line.p2(), stitch) });
+        }
+        return result;
+    };
 
-    for (auto& line : lines)
+    const size_t nPoints = m_points.size();
+
+    std::vector<RTreeValue> values;
+    for (size_t i = 0; i < nPoints; ++i)
     {
-        m_points.push_back(line.p1());
-        m_points.push_back(line.p2());
+        if (m_graph.degree(i) > 0)
+        {
+            values.push_back({ toBox(QRectF(m_points[i], m_points[i])), i });
+        }
     }
+    const RTree rtree(values.begin(), values.end());
+
+    for (size_t i = 0; i < nPoints; ++i)
+    {
+        if (m_graph.degree(i) != 1 || !nearBorder(m_points[i]))
+        {
+            continue;
+        }
 
-    std::sort(m_points.begin(), m_points.end(), lessPoint);
-    auto end2 = std::unique(m_points.begin(), m_points.end());
-    m_points.erase(end2, m_points.end());
+        const size_t neighbour = m_graph.getAdjacencyList()[i].front();
 
-    std::unordered_map<QPointF, int> indexes;
+        // candidates within the overlap, nearest first; the first visible
+        // one is the stitch
+        std::vector<std::pair<qreal, size_t>> candidates;
+        const QPointF reach(m_overlap, m_overlap);
+        for (auto it = rtree.qbegin(bgi::intersects(toBox(QRectF(m_points[i] - reach, m_points[i] + reach))));
+             it != rtree.qend(); ++it)
+        {
+            const size_t j = it->second;
+            const qreal length = euclideanDist(m_points[i], m_points[j]);
+            if (j != i && j != neighbour && length < m_overlap)
+            {
+                candidates.push_back({ length, j });
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        for (const auto& candidate : candidates)
+        {
+            const QLineF line(m_points[i], m_points[candidate.second]);
+            if (!obstacles.intersects(line, true))
+            {
+                m_graph.addEdge(i, candidate.second);
+                m_edges.push_back({ i, candidate.second, clearance(line) });
+                break;
+            }
+        }
+    }
+}
 
-    for (const auto& point : m_points)
+void VoronoiMap::filterGraph(Graph& graph)
+{
+    if (m_minClearance <= 0)
     {
-        indexes[point] = m_graph.addVertex(point);
+        return;
     }
 
-    for (const auto& line : lines)
+    for (const auto& edge : m_edges)
     {
-        if (!obstacles.intersects(line, true))
+        if (edge.clearance < m_minClearance)
         {
-            m_graph.addEdge(indexes[line.p1()], indexes[line.p2()]);
+            graph.removeEdge(edge.from, edge.to);
         }
     }
 }
 
+void VoronoiMap::setMinClearance(qreal clearance)
+{
+    m_minClearance = clearance;
+    invalidateSearch();
+}
+
+void VoronoiMap::setTiling(int nColumns, int nRows, qreal overlap, bool bStitch)
+{
+    m_nColumns = std::max(nColumns, 1);
+    m_nRows = std::max(nRows, 1);
+    m_overlap = overlap;
+    m_bStitch = bStitch;
+
+    m_tiles.clear();
+    m_outlines.clear();
+    m_obstacleHash = 0;
+}
+
 }  // namespace Motion
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "motion/algorithms/frontier.h"
+#include "motion/algorithms/utils.h"
+
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <numeric>
+#include <tuple>
+#include <unordered_map>
+
+namespace Motion
+{
+
+namespace
+{
+
+size_t findRoot(std::vector<size_t>& parents, size_t i)
+{
+    while (parents[i] != i)
+    {
+        parents[i] = parents[parents[i]];
+        i = parents[i];
+    }
+    return i;
+}
+
+}  // namespace
+
+std::vector<Frontier> clusterFrontiers(const std::vector<QPointF>& points, qreal linkDistance, qreal maxExtent)
+{
+    // points are bucketed into cells of the link distance, so only the
+    // points of the 3x3 neighbouring cells are compared
+    std::unordered_map<uint64_t, std::vector<size_t>> cells;
+    std::vector<std::pair<int64_t, int64_t>> pointCells(points.size());
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        const int64_t column = static_cast<int64_t>(std::floor(points[i].x() / linkDistance));
+        const int64_t row = static_cast<int64_t>(std::floor(points[i].y() / linkDistance));
+        pointCells[i] = { column, row };
+        cells[cellKey(column, row)].push_back(i);
+    }
+
+    std::vector<size_t> parents(points.size());
+    std::iota(parents.begin(), parents.end(), 0);
+
+    const qreal linkDistance2 = linkDistance * linkDistance;
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        for (int64_t dx = -1; dx <= 1; ++dx)
+        {
+            for (int64_t dy = -1; dy <= 1; ++dy)
+            {
+                auto it = cells.find(cellKey(pointCells[i].first + dx, pointCells[i].second + dy));
+                if (it == cells.end())
+                    continue;
+
+                for (size_t j : it->second)
+                {
+                    if (j <= i || euclideanDistSqrd(points[i], points[j]) > linkDistance2)
+                        continue;
+                    parents[findRoot(parents, j)] = findRoot(parents, i);
+                }
+            }
+        }
+    }
+
+    // chained points are split further by the square they lie in
+    std::map<std::tuple<size_t, int64_t, int64_t>, size_t> pieces;
+    std::vector<std::vector<size_t>> clusters;
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        const auto key = std::make_tuple(findRoot(parents, i),
+                                         static_cast<int64_t>(std::floor(points[i].x() / maxExtent)),
+                                         static_cast<int64_t>(std::floor(points[i].y() / maxExtent)));
+        auto it = pieces.find(key);
+        if (it == pieces.end())
+        {
+            it = pieces.emplace(key, clusters.size()).first;
+            clusters.emplace_back();
+        }
+        clusters[it->second].push_back(i);
+    }
+
+    std::vector<Frontier> frontiers;
+    for (const auto& cluster : clusters)
+    {
+        if (cluster.empty())
+            continue;
+
+        QPointF centroid;
+        for (size_t i : cluster)
+            centroid += points[i];
+        centroid /= static_cast<qreal>(cluster.size());
+
+        // the centroid itself may lie in an obstacle or in the explored area
+        size_t goal = cluster.front();
+        for (size_t i : cluster)
+        {
+            if (euclideanDistSqrd(points[i], centroid) < euclideanDistSqrd(points[goal], centroid))
+                goal = i;
+        }
+        frontiers.push_back({ points[goal], cluster.size() });
+    }
+    return frontiers;
+}
+
+}  // namespace Motion
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "motion/algorithms/path_shortcutting.h"
+#include "motion/algorithms/utils.h"
+
+#include <QLineF>
+
+#include <algorithm>
+#include <execution>
+#include <numeric>
+#include <random>
+
+namespace Motion
+{
+
+namespace
+{
+
+std::vector<char> checkBatch(const std::vector<QLineF>& lines, const PolygonSet& obstacles)
+{
+    std::vector<char> visible(lines.size());
+    std::vector<size_t> indexes(lines.size());
+    std::iota(indexes.begin(), indexes.end(), 0);
+
+    std::for_each(
+        std::execution::par,
+        indexes.begin(),
+        indexes.end(),
+        [&](size_t i)
+        {
+            visible[i] = !obstacles.intersects(lines[i], true);
+        });
+
+    return visible;
+}
+
+Path greedyShortcut(const Path& path, const PolygonSet& obstacles, size_t nBatchSize, size_t& nChecks,
+                    const CancellationToken& token)
+{
+    Path result = { path.front() };
+
+    size_t i = 0;
+    while (i < path.size() - 1)
+    {
+        if (token.isCancelled())
+        {
+            result.insert(result.end(), path.begin() + i + 1, path.end());
+            return result;
+        }
+
+        // farthest candidates first, the neighbour is always reachable
+        size_t next = i + 1;
+        for (size_t hi = path.size() - 1; hi > i + 1 && next == i + 1; )
+        {
+            const size_t lo = std::max(i + 2, hi + 1 > nBatchSize ? hi + 1 - nBatchSize : size_t(0));
+
+            std::vector<QLineF> lines;
+            for (size_t j = hi; j >= lo; --j)
+            {
+                lines.push_back(QLineF(path[i], path[j]));
+            }
+
+            std::vector<char> visible = checkBatch(lines, obstacles);
+            nChecks += lines.size();
+
+            auto it = std::find(visible.begin(), visible.end(), 1);
+            if (it != visible.end())
+            {
+                next = hi - (it - visible.begin());
+            }
+
+            hi = lo - 1;
+        }
+
+        result.push_back(path[next]);
+        i = next;
+    }
+
+    return result;
+}
+
+struct Shortcut
+{
+    size_t from;
+    size_t to;
+    QPointF p1;
+    QPointF p2;
+    qreal gain;
+};
+
+Path randomShortcut(Path path, const PolygonSet& obstacles, int nMaxChecks, int nBatchSize, size_t& nChecks,
+                    std::mt19937& random, const CancellationToken& token)
+{
+    for (int nDone = 0; nDone < nMaxChecks && path.size() > 2 && !token.isCancelled(); nDone += nBatchSize)
+    {
+        std::vector<Shortcut> candidates;
+        std::vector<QLineF> lines;
+
+        std::uniform_int_distribution<size_t> segment(0, path.size() - 2);
+        std::uniform_real_distribution<double> position(0.0, 1.0);
+        for (int k = 0; k < nBatchSize && nDone + k < nMaxChecks; ++k)
+        {
+            size_t a = segment(random);
+            size_t b = segment(random);
+            if (a == b)
+            {
+                continue;
+            }
+            if (a > b)
+            {
+                std::swap(a, b);
+            }
+
+            QPointF p1 = affineLine(path[a + 1], path[a], position(random));
+            QPointF p2 = affineLine(path[b + 1], path[b], position(random));
+
+            qreal length = euclideanDist(p1, path[a + 1]) + euclideanDist(path[b], p2);
+            for (size_t i = a + 1; i < b; ++i)
+            {
+                length += euclideanDist(path[i], path[i + 1]);
+            }
+
+            qreal gain = length - euclideanDist(p1, p2);
+            if (gain > 1e-6)
+            {
+                candidates.push_back({ a, b, p1, p2, gain });
+                lines.push_back(QLineF(p1, p2));
+            }
+        }
+
+        std::vector<char> visible = checkBatch(lines, obstacles);
+        nChecks += lines.size();
+
+        // only the best shortcut of the batch is applied, the others
+        // refer to the indexes of the path before the change
+        const Shortcut* best = nullptr;
+        for (size_t i = 0; i < candidates.size(); ++i)
+        {
+            if (visible[i] && (!best || candidates[i].gain > best->gain))
+            {
+                best = &candidates[i];
+            }
+        }
+
+        if (best)
+        {
+            Path shortened(path.begin(), path.begin() + best->from + 1);
+            shortened.push_back(best->p1);
+            shortened.push_back(best->p2);
+            shortened.insert(shortened.end(), path.begin() + best->to + 1, path.end());
+            path = shortened;
+        }
+    }
+
+    return path;
+}
+
+}  // namespace
+
+Path shortcutPath(const Path& path, const PolygonSet& obstacles,
+                  int nRandomChecks, int nBatchSize, ShortcutStats* stats,
+                  const CancellationToken& token)
+{
+    if (path.size() < 3)
+    {
+        return path;
+    }
+
+    nBatchSize = std::max(nBatchSize, 1);
+
+    size_t nChecks = 0;
+    Path result = greedyShortcut(path, obstacles, nBatchSize, nChecks, token);
+    // called from the planning threads, so the generator is not shared
+    std::mt19937 random(std::random_device{}());
+    result = randomShortcut(result, obstacles, nRandomChecks, nBatchSize, nChecks, random, token);
+
+    if (stats)
+    {
+        stats->nChecks = nChecks;
+        stats->nRemoved = path.size() > result.size() ? path.size() - result.size() : 0;
+        stats->initialLength = pathLength(path);
+        stats->finalLength = pathLength(result);
+    }
+
+    return result;
+}
+
+}  // namespace Motion
\ No newline at end of file
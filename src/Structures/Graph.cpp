@@ -4,9 +4,9 @@
 
 #include <QPen>
 
+#include <algorithm>
 #include <queue>
 #include <map>
-#include <set>
 
 namespace Motion
 {
@@ -36,6 +36,15 @@ void Graph::addEdge(size_t from, size_t to)
     m_adjacencyList[to].push_back(from);
 }
 
+void Graph::removeEdge(size_t from, size_t to)
+{
+    assert(from < m_vertices.size() && to < m_vertices.size());
+    auto& fromList = m_adjacencyList[from];
+    auto& toList = m_adjacencyList[to];
+    fromList.erase(std::remove(fromList.begin(), fromList.end(), to), fromList.end());
+    toList.erase(std::remove(toList.begin(), toList.end(), from), toList.end());
+}
+
 Graph::Node Graph::nearest(const QPointF& vertex)
 {
     assert(m_vertices.size() != 0);
@@ -106,33 +115,31 @@ Path Graph::findPath(size_t startPoint, size_t endPoint)
     }
 }
 
-void Graph::setMask(const Polygon& polygon)
+void Graph::setMask(const std::vector<bool>& valid)
 {
-    std::set<size_t> invalid;
-    int valid = 0;
+    // vertices past the mask, e.g. query points, stay valid
+    auto isValid = [&](size_t i) { return i >= valid.size() || valid[i]; };
+
+    size_t lastValid = 0;
     for (size_t i = 0; i < m_vertices.size(); ++i)
     {
-        if (!polygon.inside(m_vertices[i], false))
+        if (isValid(i))
         {
-            invalid.insert(i);
-        }
-        else
-        {
-            valid = i;
+            lastValid = i;
         }
     }
 
     for (size_t i = 0; i < m_vertices.size(); ++i)
     {
-        if (invalid.find(i) != invalid.end())
+        if (!isValid(i))
         {
-            m_vertices[i] = m_vertices[valid];
+            m_vertices[i] = m_vertices[lastValid];
         }
     }
 
     for (size_t i = 0; i < m_adjacencyList.size(); ++i)
     {
-        if (invalid.find(i) != invalid.end())
+        if (!isValid(i))
         {
             m_adjacencyList[i] = {};
             continue;
@@ -141,7 +148,7 @@ void Graph::setMask(const Polygon& polygon)
         for (size_t j = 0; j < m_adjacencyList[i].size(); ++j)
         {
             //QLineF line(m_vertices[i], m_vertices[m_adjacencyList[i][j]]);
-            if (invalid.find(m_adjacencyList[i][j]) == invalid.end())
+            if (isValid(m_adjacencyList[i][j]))
             {
                 newList.push_back(m_adjacencyList[i][j]);
             }
@@ -155,6 +162,11 @@ size_t Graph::size()
     return m_vertices.size();
 }
 
+size_t Graph::degree(size_t index) const
+{
+    return m_adjacencyList[index].size();
+}
+
 std::vector<QPointF> Graph::getVertices() const
 {
     return m_vertices;
@@ -5,6 +5,7 @@
 #include <CGAL/Boolean_set_operations_2.h>
 #include <CGAL/minkowski_sum_2.h>
 #include <CGAL/Exact_predicates_exact_constructions_kernel.h>
+#include <CGAL/Gps_segment_traits_2.h>
 #include <CGAL/Polygon_2.h>
 #include <CGAL/Polygon_with_holes_2.h>
 #include <CGAL/Vector_2.h>
@@ -373,6 +374,89 @@ bool Polygon::isSimple() const
     }
 }
 
+// Greedy pass over a ring that removes a vertex only when the chord
+// replacing it turns left or goes straight, i.e. cuts a triangle off the
+// interior (on the left of both outer boundaries and holes), and stays
+// within the tolerance of every vertex removed since the last kept one.
+Polygon_2 simplifiedRing(const Polygon_2& ring, double tolerance2)
+{
+    const std::vector<Point_2> points(ring.vertices_begin(), ring.vertices_end());
+    if (points.size() <= 3)
+        return ring;
+
+    std::vector<Point_2> kept = { points[0] };
+    std::vector<Point_2> removed;
+    for (size_t i = 1; i < points.size(); ++i)
+    {
+        const Point_2& u = kept.back();
+        const Point_2& v = points[i];
+        const Point_2& w = points[(i + 1) % points.size()];
+
+        bool bRemove = CGAL::orientation(u, v, w) != CGAL::RIGHT_TURN && u != w;
+        if (bRemove)
+        {
+            const Segment_2 chord(u, w);
+            removed.push_back(v);
+            for (const auto& point : removed)
+            {
+                if (CGAL::to_double(CGAL::squared_distance(point, chord)) > tolerance2)
+                {
+                    bRemove = false;
+                    break;
+                }
+            }
+        }
+
+        if (!bRemove)
+        {
+            kept.push_back(v);
+            removed.clear();
+        }
+    }
+
+    if (kept.size() < 3)
+        return ring;
+    return Polygon_2(kept.begin(), kept.end());
+}
+
+Polygon Polygon::simplified(qreal tolerance) const
+{
+    const Polygon_with_holes_2& polygon = m_pImpl->polygon();
+    if (polygon.outer_boundary().size() <= 3 && !polygon.has_holes())
+        return *this;
+
+    try
+    {
+        const double tolerance2 = tolerance * tolerance;
+        Polygon_with_holes_2 result(simplifiedRing(polygon.outer_boundary(), tolerance2));
+        for (auto it = polygon.holes_begin(); it != polygon.holes_end(); ++it)
+        {
+            result.add_hole(simplifiedRing(*it, tolerance2));
+        }
+
+        // a removed vertex may let a chord cross another part of the boundary
+        if (!CGAL::is_valid_polygon_with_holes(result, CGAL::Gps_segment_traits_2<Kernel>()))
+            return *this;
+
+        return Polygon(Impl(result));
+    }
+    catch (...)
+    {
+        return *this;
+    }
+}
+
+size_t Polygon::vertexCount() const
+{
+    const Polygon_with_holes_2& polygon = m_pImpl->polygon();
+    size_t count = polygon.outer_boundary().size();
+    for (auto it = polygon.holes_begin(); it != polygon.holes_end(); ++it)
+    {
+        count += it->size();
+    }
+    return count;
+}
+
 void PolygonSet::insert(const Polygon& polygon)
 {
     std::vector<Polygon> result;
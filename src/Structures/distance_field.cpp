@@ -0,0 +1,280 @@
+#include "motion/structures/distance_field.h"
+
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <limits>
+#include <numeric>
+
+namespace Motion
+{
+
+namespace
+{
+
+const qreal INF = std::numeric_limits<qreal>::max();
+
+// Felzenszwalb's one-dimensional transform: squared distances to the
+// lower envelope of the parabolas rooted at every sample.
+void transform1d(const std::vector<qreal>& f, std::vector<qreal>& d,
+                 std::vector<int>& v, std::vector<qreal>& z)
+{
+    const int n = static_cast<int>(f.size());
+    int k = -1;
+    for (int q = 0; q < n; ++q)
+    {
+        if (f[q] == INF)
+        {
+            continue;
+        }
+
+        qreal s = -INF;
+        while (k >= 0)
+        {
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0 * (q - v[k]));
+            if (s > z[k])
+            {
+                break;
+            }
+            --k;
+        }
+
+        ++k;
+        v[k] = q;
+        z[k] = k == 0 ? -INF : s;
+        z[k + 1] = INF;
+    }
+
+    if (k < 0)
+    {
+        std::fill(d.begin(), d.end(), INF);
+        return;
+    }
+
+    int j = 0;
+    for (int q = 0; q < n; ++q)
+    {
+        while (z[j + 1] < q)
+        {
+            ++j;
+        }
+        d[q] = (q - v[j]) * (q - v[j]) + f[v[j]];
+    }
+}
+
+}  // namespace
+
+DistanceField::DistanceField(const PolygonSet& obstacles, const QRectF& bounds, qreal cellSize) :
+    m_bounds(bounds),
+    m_cellSize(cellSize),
+    m_nColumns(std::max(1, static_cast<int>(std::ceil(bounds.width() / cellSize)))),
+    m_nRows(std::max(1, static_cast<int>(std::ceil(bounds.height() / cellSize)))),
+    m_cells(static_cast<size_t>(m_nColumns) * m_nRows, OUTSIDE)
+{
+    std::vector<std::vector<QPointF>> rings;
+    for (const Polygon& polygon : obstacles.getPolygons())
+    {
+        rings.push_back(polygon.points());
+        for (const auto& hole : polygon.holes())
+        {
+            rings.push_back(hole);
+        }
+    }
+
+    for (const auto& ring : rings)
+    {
+        for (size_t i = 0; i < ring.size(); ++i)
+        {
+            markBoundary(ring[i], ring[(i + 1) % ring.size()]);
+        }
+    }
+    fillInside(rings);
+
+    m_outside = distanceTransform(OUTSIDE);
+    m_inside = distanceTransform(INSIDE);
+}
+
+// Marks every cell the segment passes through, row by row.
+void DistanceField::markBoundary(const QPointF& a, const QPointF& b)
+{
+    const qreal top = std::min(a.y(), b.y());
+    const qreal bottom = std::max(a.y(), b.y());
+    const int rowFrom = std::max(0, static_cast<int>(std::floor((top - m_bounds.top()) / m_cellSize)));
+    const int rowTo = std::min(m_nRows - 1, static_cast<int>(std::floor((bottom - m_bounds.top()) / m_cellSize)));
+
+    auto xAt = [&](qreal y)
+    {
+        return a.y() == b.y() ? a.x() : a.x() + (y - a.y()) * (b.x() - a.x()) / (b.y() - a.y());
+    };
+
+    for (int row = rowFrom; row <= rowTo; ++row)
+    {
+        const qreal y0 = std::max(top, m_bounds.top() + row * m_cellSize);
+        const qreal y1 = std::min(bottom, m_bounds.top() + (row + 1) * m_cellSize);
+        qreal left = a.y() == b.y() ? std::min(a.x(), b.x()) : std::min(xAt(y0), xAt(y1));
+        qreal right = a.y() == b.y() ? std::max(a.x(), b.x()) : std::max(xAt(y0), xAt(y1));
+
+        const int columnFrom = static_cast<int>(std::floor((left - m_bounds.left()) / m_cellSize));
+        const int columnTo = static_cast<int>(std::floor((right - m_bounds.left()) / m_cellSize));
+        if (columnTo < 0 || columnFrom >= m_nColumns)
+        {
+            continue;
+        }
+
+        for (int column = std::max(0, columnFrom); column <= std::min(m_nColumns - 1, columnTo); ++column)
+        {
+            m_cells[static_cast<size_t>(row) * m_nColumns + column] = BOUNDARY;
+        }
+    }
+}
+
+// Cells not crossed by the boundary are inside when their centers are.
+void DistanceField::fillInside(const std::vector<std::vector<QPointF>>& rings)
+{
+    std::vector<int> rows(m_nRows);
+    std::iota(rows.begin(), rows.end(), 0);
+
+    std::for_each(
+        std::execution::par,
+        rows.begin(),
+        rows.end(),
+        [&](int row)
+        {
+            const qreal y = m_bounds.top() + (row + 0.5) * m_cellSize;
+
+            std::vector<qreal> crossings;
+            for (const auto& ring : rings)
+            {
+                for (size_t i = 0; i < ring.size(); ++i)
+                {
+                    const QPointF& a = ring[i];
+                    const QPointF& b = ring[(i + 1) % ring.size()];
+                    if ((a.y() > y) != (b.y() > y))
+                    {
+                        crossings.push_back(a.x() + (y - a.y()) * (b.x() - a.x()) / (b.y() - a.y()));
+                    }
+                }
+            }
+
+            std::sort(crossings.begin(), crossings.end());
+
+            for (size_t i = 0; i + 1 < crossings.size(); i += 2)
+            {
+                const int from = std::max(0, static_cast<int>(std::ceil((crossings[i] - m_bounds.left()) / m_cellSize - 0.5)));
+                const int to = std::min(m_nColumns - 1, static_cast<int>(std::floor((crossings[i + 1] - m_bounds.left()) / m_cellSize - 0.5)));
+                for (int column = from; column <= to; ++column)
+                {
+                    char& cell = m_cells[static_cast<size_t>(row) * m_nColumns + column];
+                    if (cell == OUTSIDE)
+                    {
+                        cell = INSIDE;
+                    }
+                }
+            }
+        });
+}
+
+// Exact Euclidean distance from every cell to the nearest cell of another
+// kind than empty, as two passes of the 1D transform: over the columns
+// and then over the rows, each line transformed in parallel.
+std::vector<qreal> DistanceField::distanceTransform(Cell empty) const
+{
+    std::vector<qreal> grid(m_cells.size());
+    for (size_t i = 0; i < m_cells.size(); ++i)
+    {
+        grid[i] = m_cells[i] == empty ? INF : 0;
+    }
+
+    std::vector<int> columns(m_nColumns);
+    std::iota(columns.begin(), columns.end(), 0);
+    std::for_each(
+        std::execution::par,
+        columns.begin(),
+        columns.end(),
+        [&](int column)
+        {
+            std::vector<qreal> f(m_nRows), d(m_nRows), z(m_nRows + 1);
+            std::vector<int> v(m_nRows);
+            for (int row = 0; row < m_nRows; ++row)
+                f[row] = grid[static_cast<size_t>(row) * m_nColumns + column];
+            transform1d(f, d, v, z);
+            for (int row = 0; row < m_nRows; ++row)
+                grid[static_cast<size_t>(row) * m_nColumns + column] = d[row];
+        });
+
+    std::vector<int> rows(m_nRows);
+    std::iota(rows.begin(), rows.end(), 0);
+    std::for_each(
+        std::execution::par,
+        rows.begin(),
+        rows.end(),
+        [&](int row)
+        {
+            const auto begin = grid.begin() + static_cast<size_t>(row) * m_nColumns;
+            std::vector<qreal> f(begin, begin + m_nColumns), d(m_nColumns), z(m_nColumns + 1);
+            std::vector<int> v(m_nColumns);
+            transform1d(f, d, v, z);
+            std::copy(d.begin(), d.end(), begin);
+        });
+
+    for (qreal& distance : grid)
+    {
+        distance = distance == INF ? INF : std::sqrt(distance) * m_cellSize;
+    }
+    return grid;
+}
+
+// The distance between cell centers overestimates the distance between
+// points of the cells by at most two half diagonals.
+qreal DistanceField::lowerBound(const std::vector<qreal>& distances, const QPointF& point) const
+{
+    const int column = static_cast<int>(std::floor((point.x() - m_bounds.left()) / m_cellSize));
+    const int row = static_cast<int>(std::floor((point.y() - m_bounds.top()) / m_cellSize));
+    if (column < 0 || column >= m_nColumns || row < 0 || row >= m_nRows)
+    {
+        return 0;
+    }
+
+    const qreal distance = distances[static_cast<size_t>(row) * m_nColumns + column];
+    return std::max<qreal>(0, distance - m_cellSize * std::sqrt(2.0));
+}
+
+qreal DistanceField::clearance(const QPointF& point) const
+{
+    return lowerBound(m_outside, point);
+}
+
+qreal DistanceField::depth(const QPointF& point) const
+{
+    return lowerBound(m_inside, point);
+}
+
+qreal DistanceField::signedDistance(const QPointF& point) const
+{
+    const qreal outside = clearance(point);
+    return outside > 0 ? outside : -depth(point);
+}
+
+bool DistanceField::isFree(const QLineF& segment) const
+{
+    // every step stays within the disk known to be clear around the
+    // previous point; small disks are left to the exact test
+    const qreal length = segment.length();
+    qreal t = 0;
+    while (true)
+    {
+        const QPointF point = length > 0 ? segment.pointAt(t / length) : segment.p1();
+        const qreal radius = clearance(point);
+        if (radius < m_cellSize / 2)
+        {
+            return false;
+        }
+        if (t + radius >= length)
+        {
+            return true;
+        }
+        t += radius;
+    }
+}
+
+}  // namespace Motion
\ No newline at end of file
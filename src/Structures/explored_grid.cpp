@@ -0,0 +1,245 @@
+#include "motion/structures/explored_grid.h"
+
+#include <QPainter>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Motion
+{
+
+ExploredGrid::ExploredGrid(const QRectF& bounds, qreal cellSize, const QColor& unexplored) :
+    m_bounds(bounds),
+    m_cellSize(cellSize),
+    m_unexplored(unexplored),
+    m_nColumns(std::max(1, static_cast<int>(std::ceil(bounds.width() / cellSize)))),
+    m_nRows(std::max(1, static_cast<int>(std::ceil(bounds.height() / cellSize)))),
+    m_nBlockColumns((m_nColumns + BLOCK_SIZE - 1) / BLOCK_SIZE),
+    m_nBlockRows((m_nRows + BLOCK_SIZE - 1) / BLOCK_SIZE),
+    m_blocks(static_cast<size_t>(m_nBlockColumns) * m_nBlockRows)
+{
+    clear();
+}
+
+void ExploredGrid::fill(const QPolygonF& polygon)
+{
+    if (polygon.size() < 3)
+    {
+        return;
+    }
+
+    const QRectF rect = polygon.boundingRect();
+    const int rowFrom = std::max(0, static_cast<int>(std::floor((rect.top() - m_bounds.top()) / m_cellSize)));
+    const int rowTo = std::min(m_nRows - 1, static_cast<int>(std::floor((rect.bottom() - m_bounds.top()) / m_cellSize)));
+
+    // cells that were filled, their neighbours may leave the frontier
+    int dirtyLeft = m_nColumns;
+    int dirtyRight = -1;
+    int dirtyTop = m_nRows;
+    int dirtyBottom = -1;
+
+    std::vector<qreal> crossings;
+    for (int row = rowFrom; row <= rowTo; ++row)
+    {
+        const qreal y = m_bounds.top() + (row + 0.5) * m_cellSize;
+
+        crossings.clear();
+        for (int i = 0; i < polygon.size(); ++i)
+        {
+            const QPointF& a = polygon[i];
+            const QPointF& b = polygon[(i + 1) % polygon.size()];
+            if ((a.y() > y) != (b.y() > y))
+            {
+                crossings.push_back(a.x() + (y - a.y()) * (b.x() - a.x()) / (b.y() - a.y()));
+            }
+        }
+
+        std::sort(crossings.begin(), crossings.end());
+
+        // cells whose centers lie between a pair of crossings
+        for (size_t i = 0; i + 1 < crossings.size(); i += 2)
+        {
+            const int from = std::max(0, static_cast<int>(std::ceil((crossings[i] - m_bounds.left()) / m_cellSize - 0.5)));
+            const int to = std::min(m_nColumns - 1, static_cast<int>(std::floor((crossings[i + 1] - m_bounds.left()) / m_cellSize - 0.5)));
+            if (from <= to)
+            {
+                setSpan(row, from, to);
+                dirtyLeft = std::min(dirtyLeft, from);
+                dirtyRight = std::max(dirtyRight, to);
+                dirtyTop = std::min(dirtyTop, row);
+                dirtyBottom = std::max(dirtyBottom, row);
+            }
+        }
+    }
+
+    if (dirtyRight >= 0)
+    {
+        refresh(dirtyLeft - 1, dirtyTop - 1, dirtyRight + 1, dirtyBottom + 1);
+    }
+}
+
+void ExploredGrid::clear()
+{
+    QImage image(BLOCK_SIZE, BLOCK_SIZE, QImage::Format_ARGB32);
+    image.fill(m_unexplored);
+
+    for (auto& pBlock : m_blocks)
+    {
+        pBlock = std::make_shared<Block>();
+        pBlock->image = image;
+    }
+}
+
+bool ExploredGrid::explored(const QPointF& point) const
+{
+    const int column = static_cast<int>(std::floor((point.x() - m_bounds.left()) / m_cellSize));
+    const int row = static_cast<int>(std::floor((point.y() - m_bounds.top()) / m_cellSize));
+
+    if (column < 0 || column >= m_nColumns || row < 0 || row >= m_nRows)
+    {
+        return false;
+    }
+
+    return test(column, row);
+}
+
+std::vector<QPointF> ExploredGrid::frontier() const
+{
+    std::vector<QPointF> result;
+
+    for (int blockRow = 0; blockRow < m_nBlockRows; ++blockRow)
+    {
+        for (int blockColumn = 0; blockColumn < m_nBlockColumns; ++blockColumn)
+        {
+            const Block& block = *m_blocks[static_cast<size_t>(blockRow) * m_nBlockColumns + blockColumn];
+            if (block.nFrontier == 0)
+            {
+                continue;
+            }
+
+            for (int y = 0; y < BLOCK_SIZE; ++y)
+            {
+                for (uint64_t word = block.frontier[y]; word != 0; word &= word - 1)
+                {
+                    int x = 0;
+                    while (!((word >> x) & 1))
+                    {
+                        ++x;
+                    }
+                    result.push_back(center(blockColumn * BLOCK_SIZE + x, blockRow * BLOCK_SIZE + y));
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+void ExploredGrid::draw(QPainter* pPainter) const
+{
+    for (int blockRow = 0; blockRow < m_nBlockRows; ++blockRow)
+    {
+        for (int blockColumn = 0; blockColumn < m_nBlockColumns; ++blockColumn)
+        {
+            // blocks on the right and bottom edges are only partly inside
+            const int nColumns = std::min(BLOCK_SIZE, m_nColumns - blockColumn * BLOCK_SIZE);
+            const int nRows = std::min(BLOCK_SIZE, m_nRows - blockRow * BLOCK_SIZE);
+            const QRectF target(m_bounds.left() + blockColumn * BLOCK_SIZE * m_cellSize,
+                                m_bounds.top() + blockRow * BLOCK_SIZE * m_cellSize,
+                                nColumns * m_cellSize, nRows * m_cellSize);
+
+            const Block& block = *m_blocks[static_cast<size_t>(blockRow) * m_nBlockColumns + blockColumn];
+            pPainter->drawImage(target, block.image, QRectF(0, 0, nColumns, nRows));
+        }
+    }
+}
+
+bool ExploredGrid::test(int column, int row) const
+{
+    return (block(column, row).explored[row % BLOCK_SIZE] >> (column % BLOCK_SIZE)) & 1;
+}
+
+void ExploredGrid::setSpan(int row, int from, int to)
+{
+    for (int first = from; first <= to; first = (first / BLOCK_SIZE + 1) * BLOCK_SIZE)
+    {
+        const int lo = first % BLOCK_SIZE;
+        const int hi = std::min(to, (first / BLOCK_SIZE + 1) * BLOCK_SIZE - 1) % BLOCK_SIZE;
+
+        const uint64_t upper = hi == 63 ? ~uint64_t(0) : (uint64_t(1) << (hi + 1)) - 1;
+        const uint64_t lower = (uint64_t(1) << lo) - 1;
+        const uint64_t mask = upper & ~lower;
+
+        // already explored cells leave a shared block shared
+        if ((static_cast<const ExploredGrid*>(this)->block(first, row).explored[row % BLOCK_SIZE] & mask) != mask)
+            block(first, row).explored[row % BLOCK_SIZE] |= mask;
+    }
+}
+
+void ExploredGrid::refresh(int columnFrom, int rowFrom, int columnTo, int rowTo)
+{
+    columnFrom = std::max(columnFrom, 0);
+    rowFrom = std::max(rowFrom, 0);
+    columnTo = std::min(columnTo, m_nColumns - 1);
+    rowTo = std::min(rowTo, m_nRows - 1);
+
+    const QRgb clear = qRgba(0, 0, 0, 0);
+    const QRgb unexplored = m_unexplored.rgba();
+
+    for (int row = rowFrom; row <= rowTo; ++row)
+    {
+        for (int column = columnFrom; column <= columnTo; ++column)
+        {
+            const bool bExplored = test(column, row);
+
+            // neighbours out of the bounds do not count
+            const bool bFrontier = bExplored &&
+                ((column > 0 && !test(column - 1, row)) ||
+                 (column + 1 < m_nColumns && !test(column + 1, row)) ||
+                 (row > 0 && !test(column, row - 1)) ||
+                 (row + 1 < m_nRows && !test(column, row + 1)));
+
+            const int x = column % BLOCK_SIZE;
+            const int y = row % BLOCK_SIZE;
+            const uint64_t bit = uint64_t(1) << x;
+            const QRgb pixel = bExplored ? clear : unexplored;
+
+            // shared blocks are copied only when a cell really changes
+            const Block& cells = static_cast<const ExploredGrid*>(this)->block(column, row);
+            const bool bFrontierChanged = bFrontier != bool(cells.frontier[y] & bit);
+            const bool bPixelChanged = reinterpret_cast<const QRgb*>(cells.image.constScanLine(y))[x] != pixel;
+            if (!bFrontierChanged && !bPixelChanged)
+                continue;
+
+            Block& changed = block(column, row);
+            if (bFrontierChanged)
+            {
+                changed.frontier[y] ^= bit;
+                changed.nFrontier += bFrontier ? 1 : -1;
+            }
+            if (bPixelChanged)
+                reinterpret_cast<QRgb*>(changed.image.scanLine(y))[x] = pixel;
+        }
+    }
+}
+
+ExploredGrid::Block& ExploredGrid::block(int column, int row)
+{
+    auto& pBlock = m_blocks[static_cast<size_t>(row / BLOCK_SIZE) * m_nBlockColumns + column / BLOCK_SIZE];
+    if (pBlock.use_count() > 1)
+        pBlock = std::make_shared<Block>(*pBlock);
+    return *pBlock;
+}
+
+const ExploredGrid::Block& ExploredGrid::block(int column, int row) const
+{
+    return *m_blocks[static_cast<size_t>(row / BLOCK_SIZE) * m_nBlockColumns + column / BLOCK_SIZE];
+}
+
+QPointF ExploredGrid::center(int column, int row) const
+{
+    return QPointF(m_bounds.left() + (column + 0.5) * m_cellSize,
+                   m_bounds.top() + (row + 0.5) * m_cellSize);
+}
+
+}  // namespace Motion
\ No newline at end of file
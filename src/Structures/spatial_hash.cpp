@@ -0,0 +1,72 @@
+#include "motion/structures/spatial_hash.h"
+#include "motion/algorithms/utils.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Motion
+{
+
+SpatialHash::SpatialHash(qreal cellSize) :
+    m_cellSize(cellSize)
+{
+}
+
+void SpatialHash::insert(const QPointF& point)
+{
+    // paths are inserted repeatedly, exact duplicates are kept once
+    auto& points = m_cells[key(cell(point.x()), cell(point.y()))];
+    if (std::find(points.begin(), points.end(), point) != points.end())
+    {
+        return;
+    }
+
+    points.push_back(point);
+    ++m_nPoints;
+}
+
+bool SpatialHash::contains(const QPointF& point) const
+{
+    const int64_t column = cell(point.x());
+    const int64_t row = cell(point.y());
+
+    for (int64_t dx = -1; dx <= 1; ++dx)
+    {
+        for (int64_t dy = -1; dy <= 1; ++dy)
+        {
+            auto it = m_cells.find(key(column + dx, row + dy));
+            if (it == m_cells.end())
+            {
+                continue;
+            }
+
+            for (const auto& other : it->second)
+            {
+                if (std::fabs(point.x() - other.x()) < m_cellSize &&
+                    std::fabs(point.y() - other.y()) < m_cellSize)
+                {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+void SpatialHash::clear()
+{
+    m_cells.clear();
+    m_nPoints = 0;
+}
+
+int64_t SpatialHash::cell(qreal coordinate) const
+{
+    return static_cast<int64_t>(std::floor(coordinate / m_cellSize));
+}
+
+uint64_t SpatialHash::key(int64_t column, int64_t row)
+{
+    return cellKey(column, row);
+}
+
+}  // namespace Motion
\ No newline at end of file
@@ -1,79 +1,347 @@
 #include "motion/vision.h"
-#include "motion/algorithms/convex_hull.h"
 #include "motion/algorithms/utils.h"
 #include "motion/display_view.h"
 
 #include <QGraphicsEllipseItem>
 #include <QGraphicsPolygonItem>
 #include <QGraphicsRectItem>
+#include <QMetaObject>
 #include <QPainter>
+#include <QTimer>
 #include <QVector>
 #include <QVector2D>
 
+#include <boost/geometry/geometry.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+#include <algorithm>
+#include <cmath>
 #include <functional>
 #include <execution>
-#include <mutex>
+#include <numeric>
+#include <optional>
+#include <set>
 
 namespace Motion
 {
 
+namespace bg = boost::geometry;
+namespace bgi = boost::geometry::index;
+
+typedef bg::model::point<qreal, 2, bg::cs::cartesian> RTreePoint;
+typedef bg::model::box<RTreePoint> RTreeBox;
+typedef std::pair<RTreeBox, size_t> RTreeValue;
+
 int D = 750;
+const qreal EXPLORED_CELL_SIZE = 5;
+// side of the squares the dark area starts from, close to the vision size
+const qreal DARK_TILE_SIZE = 500;
+
+// Bounds of the obstacles, queried around the device on every update.
+struct Vision::ObstacleIndex
+{
+    ObstacleIndex(const std::vector<RTreeValue>& values)
+        : rtree(values.begin(), values.end()) {}
+
+    bgi::rtree<RTreeValue, bgi::quadratic<16>> rtree;
+};
 
-Polygon getShadow1(const QPolygonF& polygon, QPointF pos)
+QPolygonF getEllipse(QPointF center, int radius, int n = 30)
 {
-    std::vector<QPointF> result = polygon.toList().toVector().toStdVector();
-    for (const QPointF& p : polygon)
+    QPolygonF result;
+    double theta = 3.14159265358979323846 * 2 / n;
+    for (int i = 0; i < n; ++i)
     {
-        QPointF newP = (QVector2D(p) + QVector2D(p - pos).normalized() * 5000).toPoint();
-        result.push_back(newP);
+        double newX = sin(theta * i) * radius + center.x();
+        double newY = cos(theta * i) * radius + center.y();
+        result.push_back(QPointF(newX, newY));
     }
-    return Polygon(unclose(convexHull(result)));
+    return result;
 }
 
-Polygon getShadow2(const QPolygonF& polygon, QPointF pos)
+namespace
 {
 
-    const auto points1 = polygon.toList().toVector().toStdVector();
-    std::vector<QPointF> points2;
-    for (const QPointF& p : polygon)
-    {
-        QPointF newP = (QVector2D(p) + QVector2D(p - pos).normalized() * 5000).toPoint();
-        points2.push_back(newP);
-    }
+qreal cross(const QPointF& u, const QPointF& v)
+{
+    return u.x() * v.y() - u.y() * v.x();
+}
+
+// Sign of the turn a -> b -> c, 0 within the tolerance.
+int orientation(const QPointF& a, const QPointF& b, const QPointF& c)
+{
+    constexpr double EPS = 1e-9;
+    const QPointF u = b - a;
+    const QPointF v = c - a;
+    const qreal value = cross(u, v);
+    const qreal tolerance = EPS * std::sqrt(QPointF::dotProduct(u, u) * QPointF::dotProduct(v, v));
+    return value > tolerance ? 1 : value < -tolerance ? -1 : 0;
+}
 
-    Polygon result(polygon);
-    for (int i = 0; i < points1.size() - 1; ++i)
+// Cyrus-Beck clipping of the segment to a convex counterclockwise polygon.
+std::optional<QLineF> clipped(const QLineF& segment, const QPolygonF& convex)
+{
+    qreal t0 = 0;
+    qreal t1 = 1;
+    const QPointF d = segment.p2() - segment.p1();
+    for (int i = 0; i < convex.size(); ++i)
     {
-        if (points1[i] == points1[i + 1])
+        const QPointF a = convex[i];
+        const QPointF edge = convex[(i + 1) % convex.size()] - a;
+        // inside is on the left of every edge
+        const qreal numerator = cross(edge, segment.p1() - a);
+        const qreal denominator = cross(edge, d);
+        if (denominator == 0)
+        {
+            if (numerator < 0)
+                return std::nullopt;
             continue;
-        auto p = QPolygonF({ points1[i], points2[i], points2[i + 1], points1[i + 1] });
-        result = result.united(Polygon(p));
-    }
+        }
 
+        const qreal t = -numerator / denominator;
+        if (denominator > 0)
+            t0 = std::max(t0, t);
+        else
+            t1 = std::min(t1, t);
+    }
 
-    return result;
+    if (t0 >= t1)
+        return std::nullopt;
+    return QLineF(segment.pointAt(t0), segment.pointAt(t1));
 }
 
-Polygon getShadow(const QPolygonF& polygon, QPointF pos)
+// Orders segments that do not cross by their distance from the origin
+// along any ray meeting both; the segments are oriented counterclockwise
+// around the origin.
+struct Closer
 {
-    if (!isConvex(polygon))
-        return getShadow2(polygon, pos);
-    return getShadow1(polygon, pos);
-}
+    const std::vector<QLineF>* pSegments;
+    QPointF origin;
 
-QPolygonF getEllipse(QPointF center, int radius, int n = 30)
+    bool operator()(size_t first, size_t second) const
+    {
+        if (first == second)
+            return false;
+
+        QPointF a = (*pSegments)[first].p1(), b = (*pSegments)[first].p2();
+        QPointF c = (*pSegments)[second].p1(), d = (*pSegments)[second].p2();
+
+        // a common endpoint becomes a and c
+        if (b == c || b == d)
+            std::swap(a, b);
+        if (a == d)
+            std::swap(c, d);
+
+        if (a == c)
+        {
+            if (b == d || orientation(origin, a, d) != orientation(origin, a, b))
+                return false;
+            return orientation(a, b, d) != orientation(a, b, origin);
+        }
+
+        const int cda = orientation(c, d, a);
+        const int cdb = orientation(c, d, b);
+        if (cda == 0 && cdb == 0)
+            return QPointF::dotProduct(a - origin, a - origin) < QPointF::dotProduct(c - origin, c - origin);
+
+        // the first segment lies on one side of the line of the second
+        if (cda == cdb || cda == 0 || cdb == 0)
+        {
+            const int cdo = orientation(c, d, origin);
+            return cdo == cda || cdo == cdb;
+        }
+
+        // otherwise the second lies on one side of the line of the first
+        const int side = orientation(a, b, c) != 0 ? orientation(a, b, c) : orientation(a, b, d);
+        return orientation(a, b, origin) != side;
+    }
+};
+
+}  // namespace
+
+// Visible part of the disk around the origin as an angular sweep over
+// the obstacle boundaries, which do not cross each other. The edges of
+// the n-gon approximating the disk stop the rays that miss every obstacle,
+// obstacle segments are clipped to it. Active segments are kept ordered
+// by distance, the visible boundary changes only where the nearest one
+// does.
+QPolygonF visibilityPolygon(const QPointF& origin, int radius, const QPolygonFList& obstacles, int n = 30)
 {
+    constexpr double EPS = 1e-5;
+
+    QPolygonF ring = getEllipse(origin, radius, n);
+    if (cross(ring[1] - ring[0], ring[2] - ring[1]) < 0)
+        std::reverse(ring.begin(), ring.end());
+
+    std::vector<QLineF> segments;
+    for (int i = 0; i < ring.size(); ++i)
+    {
+        segments.push_back(QLineF(ring[i], ring[(i + 1) % ring.size()]));
+    }
+
+    for (const auto& obstacle : obstacles)
+    {
+        for (int i = 0; i < obstacle.size(); ++i)
+        {
+            const auto part = clipped(QLineF(obstacle[i], obstacle[(i + 1) % obstacle.size()]), ring);
+            if (!part)
+                continue;
+
+            // segments seen edge-on hide nothing, their neighbours do
+            const int turn = orientation(origin, part->p1(), part->p2());
+            if (turn > 0)
+                segments.push_back(*part);
+            else if (turn < 0)
+                segments.push_back(QLineF(part->p2(), part->p1()));
+        }
+    }
+
+    struct Event
+    {
+        double angle;
+        bool bStart;
+        size_t segment;
+        QPointF point;
+    };
+
+    auto angleOf = [&origin](const QPointF& point)
+    {
+        return std::atan2(point.y() - origin.y(), point.x() - origin.x());
+    };
+
+    Closer closer{ &segments, origin };
+    std::set<size_t, Closer> active(closer);
+    std::vector<std::set<size_t, Closer>::iterator> handles(segments.size(), active.end());
+
+    // the sweep starts at the angle -pi, segments crossing it are active
+    // from the start
+    std::vector<Event> events;
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        const double from = angleOf(segments[i].p1());
+        const double to = angleOf(segments[i].p2());
+        if (from > to)
+        {
+            handles[i] = active.insert(i).first;
+        }
+
+        events.push_back({ from, true, i, segments[i].p1() });
+        events.push_back({ to, false, i, segments[i].p2() });
+    }
+
+    std::sort(events.begin(), events.end(), [](const Event& first, const Event& second)
+    {
+        return first.angle < second.angle;
+    });
+
+    // point of the segment on the ray towards the event point
+    auto hit = [&](size_t segment, const QPointF& point)
+    {
+        const QLineF& line = segments[segment];
+        if (line.p1() == point || line.p2() == point)
+            return point;
+
+        const QPointF direction = point - origin;
+        const QPointF d = line.p2() - line.p1();
+        const qreal denominator = cross(direction, d);
+        if (denominator == 0)
+            return line.p1();
+
+        const qreal u = std::clamp(cross(line.p1() - origin, direction) / denominator, 0.0, 1.0);
+        return line.pointAt(u);
+    };
+
+    // hits on the same segment are collinear, only the extreme ones are kept
+    auto redundant = [&](const QPointF& a, const QPointF& b, const QPointF& c)
+    {
+        const QPointF u = b - a;
+        const QPointF v = c - b;
+        return std::abs(cross(u, v)) <= EPS * EPS * std::sqrt(QPointF::dotProduct(u, u) * QPointF::dotProduct(v, v))
+            && QPointF::dotProduct(u, v) >= 0;
+    };
+
     QPolygonF result;
-    double theta = 3.14159265358979323846 * 2 / n;
-    for (int i = 0; i < n; ++i)
+    auto append = [&](const QPointF& point)
     {
-        double newX = sin(theta * i) * radius + center.x();
-        double newY = cos(theta * i) * radius + center.y();
-        result.push_back(QPointF(newX, newY));
+        if (!result.isEmpty() && result.last() == point)
+        {
+            return;
+        }
+        while (result.size() > 1 && redundant(result[result.size() - 2], result.last(), point))
+        {
+            result.pop_back();
+        }
+        result.push_back(point);
+    };
+
+    // events on one ray are applied together, the boundary jumps along
+    // the ray where the nearest segment changes
+    for (size_t i = 0; i < events.size(); )
+    {
+        size_t j = i;
+        while (j < events.size() && (j == i || (orientation(origin, events[i].point, events[j].point) == 0 &&
+                                                QPointF::dotProduct(events[i].point - origin, events[j].point - origin) > 0)))
+        {
+            ++j;
+        }
+
+        const size_t before = active.empty() ? segments.size() : *active.begin();
+        for (size_t k = i; k < j; ++k)
+        {
+            if (!events[k].bStart && handles[events[k].segment] != active.end())
+            {
+                active.erase(handles[events[k].segment]);
+                handles[events[k].segment] = active.end();
+            }
+        }
+        for (size_t k = i; k < j; ++k)
+        {
+            if (events[k].bStart && handles[events[k].segment] == active.end())
+            {
+                handles[events[k].segment] = active.insert(events[k].segment).first;
+            }
+        }
+        const size_t after = active.empty() ? segments.size() : *active.begin();
+
+        if (before != after && before < segments.size() && after < segments.size())
+        {
+            append(hit(before, events[i].point));
+            append(hit(after, events[i].point));
+        }
+        i = j;
+    }
+
+    // the sweep ends where it started
+    while (result.size() > 2 && (result.last() == result.first() ||
+                                 redundant(result[result.size() - 2], result.last(), result.first())))
+    {
+        result.pop_back();
+    }
+    while (result.size() > 2 && redundant(result.last(), result.first(), result[1]))
+    {
+        result.erase(result.begin());
     }
+
     return result;
 }
 
+// Result of one sensor update. It is published as a whole and never
+// modified afterwards, so readers keep a consistent view while the next
+// one is computed.
+struct Vision::State
+{
+    QPointF pos;
+    Polygon currentVision;
+    QPolygonF vision;
+    Polygon history;
+    std::vector<Polygon> darkPolygons;
+    QPolygonFList dark;
+    std::shared_ptr<const ExploredGrid> pExplored;
+    int nUpdates = 0;
+    // the history was simplified and may have lost explored area
+    bool bSimplified = false;
+};
+
 class QVision : public QGraphicsItem
 {
 public:
@@ -81,11 +349,15 @@ public:
 
     void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
     {
-        //painter->drawPolygon(m_pVision->m_vision);
+        const auto pState = m_pVision->state();
+
+        //painter->drawPolygon(pState->vision);
         painter->setBrush(QBrush(QColor(0, 0, 0, 180), Qt::BrushStyle::SolidPattern));
         painter->setPen(QPen(Qt::NoPen));
-        for (const auto& p : m_pVision->m_dark)
+        for (const auto& p : pState->dark)
             painter->drawPolygon(p);
+        if (pState->pExplored)
+            pState->pExplored->draw(painter);
 
         painter->setBrush(QBrush(QColor(0, 0, 0, 0), Qt::BrushStyle::SolidPattern));
         painter->setPen(QPen(Qt::green, 10));
@@ -106,13 +378,15 @@ private:
 };
 
 Vision::Vision(QGraphicsItemGroup* pGroup) :
-    m_pGroup(pGroup)
+    m_pGroup(pGroup),
+    m_pContext(std::make_unique<QObject>())
 {
     reset();
 }
 
 Vision::~Vision()
 {
+    waitForUpdate();
     //if (m_pDrawPath)
     //    delete m_pDrawPath;
 }
@@ -129,8 +403,100 @@ bool Vision::getEnabled()
     return m_bEnabled;
 }
 
+void Vision::setAsync(bool bAsync)
+{
+    m_bAsync = bAsync;
+}
+
+void Vision::setMaxUpdateRate(qreal rate)
+{
+    m_maxUpdateRate = rate;
+}
+
+void Vision::setRaster(bool bRaster)
+{
+    m_bRaster = bRaster;
+    if (m_bEnabled)
+        reset();
+}
+
+bool Vision::getRaster()
+{
+    return m_bRaster;
+}
+
+void Vision::setSimplification(qreal tolerance, int nInterval)
+{
+    m_simplifyTolerance = tolerance;
+    m_nSimplifyInterval = nInterval;
+}
+
+size_t Vision::getHistoryVertexCount() const
+{
+    return state()->history.vertexCount();
+}
+
+Polygon Vision::getVisionHistory() const
+{
+    return state()->history;
+}
+
+bool Vision::isExplored(const QPointF& point) const
+{
+    const auto pState = state();
+    if (pState->pExplored)
+        return pState->pExplored->explored(point);
+    return pState->history.inside(point);
+}
+
+MaskPredicate Vision::getExploredMask() const
+{
+    std::shared_ptr<const State> pState = state();
+    return [pState](const QPointF& point)
+    {
+        if (pState->pExplored)
+            return pState->pExplored->explored(point);
+        return pState->history.inside(point, false);
+    };
+}
+
+std::shared_ptr<const Vision::State> Vision::state() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pState;
+}
+
+void Vision::publish(std::shared_ptr<const State> pState)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_revealed = m_revealed.united(pState->vision.boundingRect());
+    if (pState->bSimplified)
+        m_bShrunk = true;
+    m_pState = std::move(pState);
+}
+
+QRectF Vision::takeRevealedBounds()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const QRectF revealed = m_revealed;
+    m_revealed = QRectF();
+    return revealed;
+}
+
+bool Vision::takeShrunk()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const bool bShrunk = m_bShrunk;
+    m_bShrunk = false;
+    return bShrunk;
+}
+
 void Vision::reset(std::optional<QPointF> pos)
 {
+    waitForUpdate();
+    m_pendingPos.reset();
+    m_sinceUpdate.invalidate();
+
     if (m_pDrawPath)
     {
         m_pGroup->removeFromGroup(m_pDrawPath);
@@ -138,23 +504,41 @@ void Vision::reset(std::optional<QPointF> pos)
         m_pDrawPath = nullptr;
     }
     m_obstacles = {};
-    m_dark = {};
-    m_currentVision = {};
-    m_visionHistory = {};
+    m_pObstacleIndex.reset();
     m_known = {};
     m_unknown = {};
-    m_vision = {};
     m_pDrawPath = new QVision(this);
     m_pGroup->addToGroup(m_pDrawPath);
     m_scene = Polygon(unclose(QPolygonF(getSceneBBox(1.75))));
+
+    auto pState = std::make_shared<State>();
+    if (m_bRaster)
+        pState->pExplored = std::make_shared<ExploredGrid>(getSceneBBox(1.75), EXPLORED_CELL_SIZE, QColor(0, 0, 0, 180));
+    else
+    {
+        // separate tiles keep every dark piece local, so an update only
+        // subtracts from the pieces near the device
+        const QRectF scene = getSceneBBox(1.75);
+        for (qreal y = scene.top(); y < scene.bottom(); y += DARK_TILE_SIZE)
+        {
+            for (qreal x = scene.left(); x < scene.right(); x += DARK_TILE_SIZE)
+            {
+                const QRectF tile = QRectF(x, y, DARK_TILE_SIZE, DARK_TILE_SIZE).intersected(scene);
+                pState->darkPolygons.push_back(Polygon(unclose(QPolygonF(tile))));
+                pState->dark.push_back(pState->darkPolygons.back().toPolygon());
+            }
+        }
+    }
+    publish(pState);
+
     m_obss = {};
     if (!pos)
     {
         DisplayView* pDisplayView = DisplayView::getInstance();
         pos = pDisplayView->getDevicePosition();
     }
-    update(*pos);
-    update(*pos); // by design (fixes bug)
+    flush(*pos);
+    flush(*pos); // by design (fixes bug)
     calculateBorder();
 }
 
@@ -163,44 +547,167 @@ void Vision::update(QPointF pos)
     if (!m_bEnabled)
         return;
 
-    m_pos = pos;
-
-    if (m_obss.size() == 0)
+    if (!m_bAsync)
     {
-        DisplayView* pDisplayView = DisplayView::getInstance();
-        m_obstacles = pDisplayView->getObstacles();
-        for (const auto& obs : m_obstacles)
-            m_obss.insert(Polygon(obs));
+        flush(pos);
+        return;
     }
 
+    m_pendingPos = pos;
+    schedule();
+}
+
+void Vision::flush(QPointF pos)
+{
+    if (!m_bEnabled)
+        return;
 
-    m_currentVision = Polygon(unclose(getEllipse(m_pos, D / 2)));
+    m_pendingPos.reset();
+    waitForUpdate();
+    loadObstacles();
+    publish(nextState(*state(), pos, m_simplifyTolerance, m_nSimplifyInterval));
+    m_pDrawPath->update();
+}
 
-    //std::vector<QPointF> newUnknown;
-    //for (const auto& p : m_unknown)
-    //{
-    //    if (euclideanDist(p, m_pos) > 100)
-    //        newUnknown.push_back(p);
-    //}
-    //m_unknown = newUnknown;
+// Starts the worker on the latest pending position unless it is busy or
+// the rate limit defers it; the worker reschedules itself when it ends.
+void Vision::schedule()
+{
+    if (!m_pendingPos || m_bUpdating || m_bDeferred)
+        return;
 
-    for (int i = 0; i < m_obstacles.size(); ++i)
+    if (m_maxUpdateRate > 0 && m_sinceUpdate.isValid())
     {
-        const auto& obstacle = m_obstacles[i];
-        Polygon shadow = getShadow(obstacle, pos);
-        if (m_currentVision.bounds().intersects(shadow.bounds()))
+        const qint64 remaining = qRound64(1000 / m_maxUpdateRate) - m_sinceUpdate.elapsed();
+        if (remaining > 0)
         {
-            m_currentVision = m_currentVision.subtracted(shadow).toPolygon();
+            m_bDeferred = true;
+            QTimer::singleShot(static_cast<int>(remaining), m_pContext.get(), [this]()
+            {
+                m_bDeferred = false;
+                schedule();
+            });
+            return;
         }
     }
 
-    if (m_visionHistory.points().empty())
-        m_visionHistory = m_currentVision;
+    loadObstacles();
+    const QPointF pos = *m_pendingPos;
+    const std::shared_ptr<const State> pState = state();
+    // the settings may change on this thread while the worker runs
+    const qreal simplifyTolerance = m_simplifyTolerance;
+    const int nSimplifyInterval = m_nSimplifyInterval;
+    m_pendingPos.reset();
+    m_sinceUpdate.start();
+    m_bUpdating = true;
+
+    m_update = std::async(std::launch::async, [this, pState, pos, simplifyTolerance, nSimplifyInterval]()
+    {
+        publish(nextState(*pState, pos, simplifyTolerance, nSimplifyInterval));
+
+        QMetaObject::invokeMethod(m_pContext.get(), [this]()
+        {
+            m_bUpdating = false;
+            m_pDrawPath->update();
+            schedule();
+        }, Qt::QueuedConnection);
+    });
+}
+
+void Vision::waitForUpdate()
+{
+    if (m_update.valid())
+        m_update.wait();
+    m_bUpdating = false;
+}
+
+void Vision::loadObstacles()
+{
+    if (m_obss.size() != 0)
+        return;
+
+    DisplayView* pDisplayView = DisplayView::getInstance();
+    for (const auto& obs : pDisplayView->getObstacles())
+        m_obss.insert(Polygon(obs));
+
+    // the sweep needs boundaries that do not cross, so it sees the union
+    auto ring = [](const std::vector<QPointF>& points)
+    {
+        QPolygonF result;
+        for (const QPointF& point : points)
+            result.append(point);
+        return result;
+    };
+
+    m_obstacles = {};
+    for (const Polygon& polygon : m_obss.getPolygons())
+    {
+        m_obstacles.push_back(ring(polygon.points()));
+        for (const auto& hole : polygon.holes())
+            m_obstacles.push_back(ring(hole));
+    }
+
+    std::vector<RTreeValue> values;
+    for (size_t i = 0; i < m_obstacles.size(); ++i)
+    {
+        const QRectF bounds = m_obstacles[i].boundingRect();
+        values.push_back({ RTreeBox(RTreePoint(bounds.left(), bounds.top()),
+                                    RTreePoint(bounds.right(), bounds.bottom())), i });
+    }
+    m_pObstacleIndex = std::make_unique<ObstacleIndex>(values);
+}
+
+// Runs on the worker: reads only the previous state and the obstacles,
+// which stay unchanged while an update is running, and the given settings.
+std::shared_ptr<const Vision::State> Vision::nextState(const State& state, const QPointF& pos,
+                                                       qreal simplifyTolerance, int nSimplifyInterval) const
+{
+    auto pNext = std::make_shared<State>();
+    pNext->pos = pos;
+    pNext->vision = visibilityPolygon(pos, D / 2, obstaclesInRange(pos, D / 2));
+    pNext->currentVision = Polygon(pNext->vision);
+    pNext->nUpdates = state.nUpdates + 1;
+
+    if (state.pExplored)
+    {
+        // the copy shares the blocks the fill does not touch
+        auto pExplored = std::make_shared<ExploredGrid>(*state.pExplored);
+        pExplored->fill(pNext->vision);
+        pNext->pExplored = pExplored;
+    }
+    else if (state.history.points().empty())
+        pNext->history = pNext->currentVision;
     else
-        m_visionHistory.unite(m_currentVision);
+    {
+        pNext->history = state.history;
+        pNext->history.unite(pNext->currentVision);
+    }
 
-    calculateDark();
-    m_pDrawPath->update();
+    if (!pNext->pExplored && nSimplifyInterval > 0 && pNext->nUpdates % nSimplifyInterval == 0)
+    {
+        pNext->history = pNext->history.simplified(simplifyTolerance);
+        pNext->bSimplified = true;
+    }
+
+    calculateDark(state, *pNext);
+    return pNext;
+}
+
+QPolygonFList Vision::obstaclesInRange(const QPointF& pos, qreal radius) const
+{
+    QPolygonFList result;
+    if (!m_pObstacleIndex)
+    {
+        return result;
+    }
+
+    const RTreeBox box(RTreePoint(pos.x() - radius, pos.y() - radius),
+                       RTreePoint(pos.x() + radius, pos.y() + radius));
+    for (auto it = m_pObstacleIndex->rtree.qbegin(bgi::intersects(box)); it != m_pObstacleIndex->rtree.qend(); ++it)
+    {
+        result.push_back(m_obstacles[it->second]);
+    }
+    return result;
 }
 
 void Vision::calculateBorder()
@@ -223,66 +730,77 @@ void Vision::calculateBorder()
 
     DisplayView* pDisplayView = DisplayView::getInstance();
     auto mSums = pDisplayView->getObstaclesMSums();
-
-    QPolygonF vision = m_visionHistory.toPolygon();
+    const auto pField = pDisplayView->getDistanceField();
+
+    // candidates are the vertices of the history polygon or the frontier
+    // cells of the raster, probed at the scale of their spacing
+    const auto pState = state();
+    std::vector<QPointF> vision;
+    qreal offset = 1;
+    if (pState->pExplored)
+    {
+        vision = pState->pExplored->frontier();
+        offset = pState->pExplored->cellSize();
+    }
+    else
+    {
+        QPolygonF history = pState->history.toPolygon();
+        vision.assign(history.begin(), history.end());
+    }
     
-    std::mutex mtx;
-    bool skipKnown = false;
-    auto func =
-        [&](auto&& vision)
-    {
-        QPointF p[3] = {
-        (QVector2D(vision) + QVector2D(1, 1)).toPointF(),
-        (QVector2D(vision) + QVector2D(-1, 1)).toPointF(),
-        (QVector2D(vision) + QVector2D(0, -1)).toPointF(),
-        };
-        bool inside = false;
-        if (!inside)
-            inside = m_obss.intersects(QLineF(p[0], p[1]));
-        if (!inside)
-            inside = m_obss.intersects(QLineF(p[1], p[2]));
-        if (!inside)
-            inside = m_obss.intersects(QLineF(p[2], p[0]));
-        mtx.lock();
-        if (getSceneBBox().contains(vision))
-            if (inside)
-            {
-                if (!skipKnown)
-                    m_known.push_back(vision);
-            }
-            else
-            {
-                //m_unknown.push_back(vision);
-                Polygon outPol;
-                //m_known.push_back(vision);
-                if (mSums.inside(vision, true))
-                {
-                    //std::vector<QPointF> outP;
-                    //QLineF line(pDisplayView->getDevicePosition(), vision);
-                    //outPol.intersects(line, false, &outP);
-                    //for (const auto& p : outP)
-                    //{
-                    //    auto shifted = affineLine2(pDisplayView->getDevicePosition(), p, 50);
-                    //    if (m_currentVision.inside(shifted) && !mSums.inside(shifted))
-                    //        m_unknown.push_back(shifted);
-                    //}
-                    ////m_unknown.insert(m_unknown.begin(), outP.begin(), outP.end());
-                    ////m_unknown.push_back();
-                }
-                else
-                {
-                    m_unknown.push_back(vision);
-                }
-            }
-        mtx.unlock();
-    };
+    // each candidate is classified into its own slot, the slots are
+    // merged in order afterwards
+    enum Border : char { NONE, KNOWN, UNKNOWN };
+    const QRectF scene = getSceneBBox();
+    std::vector<char> border(vision.size(), NONE);
+    std::vector<size_t> indexes(vision.size());
+    std::iota(indexes.begin(), indexes.end(), 0);
 
     std::for_each(
         std::execution::par,
-        vision.begin(),
-        vision.end(),
-        func);
-
+        indexes.begin(),
+        indexes.end(),
+        [&](size_t i)
+        {
+            const QPointF& point = vision[i];
+            if (!scene.contains(point))
+                return;
+
+            QPointF p[3] = {
+            (QVector2D(point) + QVector2D(offset, offset)).toPointF(),
+            (QVector2D(point) + QVector2D(-offset, offset)).toPointF(),
+            (QVector2D(point) + QVector2D(0, -offset)).toPointF(),
+            };
+            bool inside = false;
+            if (!inside)
+                inside = m_obss.intersects(QLineF(p[0], p[1]));
+            if (!inside)
+                inside = m_obss.intersects(QLineF(p[1], p[2]));
+            if (!inside)
+                inside = m_obss.intersects(QLineF(p[2], p[0]));
+
+            //m_unknown.push_back(vision);
+            //m_known.push_back(vision);
+            if (inside)
+                border[i] = KNOWN;
+            else if (pField->isInside(point))
+            {
+                //std::vector<QPointF> outP;
+                //QLineF line(pDisplayView->getDevicePosition(), vision);
+                //outPol.intersects(line, false, &outP);
+                //for (const auto& p : outP)
+                //{
+                //    auto shifted = affineLine2(pDisplayView->getDevicePosition(), p, 50);
+                //    if (m_currentVision.inside(shifted) && !mSums.inside(shifted))
+                //        m_unknown.push_back(shifted);
+                //}
+                ////m_unknown.insert(m_unknown.begin(), outP.begin(), outP.end());
+                ////m_unknown.push_back();
+                return;
+            }
+            else if (pField->isFree(point) || !mSums.inside(point, true))
+                border[i] = UNKNOWN;
+        });
 
     //std::vector<QPointF> pts;
     //for (int i = 0; i < vision.size(); ++i)
@@ -312,16 +830,48 @@ void Vision::calculateBorder()
     //    pts.begin(),
     //    pts.end(),
     //    func);
+
+    for (size_t i = 0; i < vision.size(); ++i)
+    {
+        if (border[i] == KNOWN)
+            m_known.push_back(vision[i]);
+        else if (border[i] == UNKNOWN)
+            m_unknown.push_back(vision[i]);
+    }
 }
 
-void Vision::calculateDark()
+void Vision::calculateDark(const State& previous, State& state) const
 {
-    m_vision = m_currentVision.toPolygon();
-    QPolygonF vision = m_visionHistory.toPolygon();
-    auto sub = m_scene.subtracted(m_visionHistory);
-    m_dark = {};
-    for (const auto& s : sub)
-        m_dark.push_back(s.toPolygon());
+    // the grid keeps its own image
+    if (state.pExplored)
+        return;
+
+    if (state.vision == previous.vision)
+    {
+        state.darkPolygons = previous.darkPolygons;
+        state.dark = previous.dark;
+        return;
+    }
+
+    // the dark area is the scene minus the history, so only the parts
+    // near the current vision lose anything when it is added
+    const QRectF bounds = state.currentVision.bounds();
+    for (size_t i = 0; i < previous.darkPolygons.size(); ++i)
+    {
+        if (!previous.darkPolygons[i].bounds().intersects(bounds))
+        {
+            state.darkPolygons.push_back(previous.darkPolygons[i]);
+            state.dark.push_back(previous.dark[i]);
+            continue;
+        }
+
+        auto sub = previous.darkPolygons[i].subtracted(state.currentVision);
+        for (const auto& s : sub)
+        {
+            state.darkPolygons.push_back(s);
+            state.dark.push_back(s.toPolygon());
+        }
+    }
 }
 
 }  // namespace Motion
\ No newline at end of file
@@ -10,12 +10,16 @@
 #include "motion/algorithms/find_methods/rrt.h"
 #include "motion/algorithms/find_methods/visibility_graph.h"
 #include "motion/algorithms/find_methods/voronoi_map.h"
+#include "motion/algorithms/find_methods/probabilistic_roadmap.h"
+#include "motion/algorithms/utils.h"
 #include "motion/generate/generate_random.h"
 #include "motion/generate/generate_labyrinth.h"
 #include "motion/generate/generate_poly_labyrinth.h"
 
 #include <QFileDialog>
 
+#include <algorithm>
+
 namespace Motion
 {
 
@@ -46,6 +50,7 @@ AppWindow::AppWindow(QWidget *parent) : QMainWindow(parent)
     connect(m_ui.actionRapidly_exploring_random_tree, SIGNAL(triggered()), this, SLOT(rapidlyExploringRandomTree()));
     connect(m_ui.actionShortest_path_roadmap, SIGNAL(triggered()), this, SLOT(shortestPathRoadmap()));
     connect(m_ui.actionVoronoi_map, SIGNAL(triggered()), this, SLOT(voronoiMap()));
+    connect(m_ui.actionProbabilistic_roadmap, SIGNAL(triggered()), this, SLOT(probabilisticRoadmap()));
 
     // Generate Map
     connect(m_ui.actionRandom, SIGNAL(triggered()), this, SLOT(generateRandom()));
@@ -55,6 +60,11 @@ AppWindow::AppWindow(QWidget *parent) : QMainWindow(parent)
     // Settings
     connect(m_ui.actionUsing_sensors, SIGNAL(triggered()), this, SLOT(useSensors()));
     connect(m_ui.actionSnapping, SIGNAL(triggered()), this, SLOT(useSnapping()));
+    connect(m_ui.actionLazy_validation, SIGNAL(triggered()), this, SLOT(useLazyValidation()));
+    connect(m_ui.actionRaster_fog, SIGNAL(triggered()), this, SLOT(useRasterFog()));
+    connect(m_ui.actionSimplify_history, SIGNAL(triggered()), this, SLOT(useHistorySimplification()));
+    connect(m_ui.actionBackground_vision, SIGNAL(triggered()), this, SLOT(useBackgroundVision()));
+    connect(m_ui.actionVoronoi_clearance, SIGNAL(triggered()), this, SLOT(useVoronoiClearance()));
 
     // Help
     connect(m_ui.actionAbout, SIGNAL(triggered()), this, SLOT(about()));
@@ -176,7 +186,7 @@ void AppWindow::shortestPathRoadmap()
 
     setMenuActionsChecked(m_ui.menuMethod, false);
     m_ui.actionShortest_path_roadmap->setChecked(true);
-    pDisplayView->setFindMethod(new VisibilityGraph());
+    pDisplayView->setFindMethod(new VisibilityGraph(m_ui.actionLazy_validation->isChecked()));
 }
 
 void AppWindow::voronoiMap()
@@ -186,7 +196,36 @@ void AppWindow::voronoiMap()
 
     setMenuActionsChecked(m_ui.menuMethod, false);
     m_ui.actionVoronoi_map->setChecked(true);
-    pDisplayView->setFindMethod(new VoronoiMap(DisplayView::WIDTH, DisplayView::HEIGHT));
+
+    VoronoiMap* pVoronoiMap = new VoronoiMap(DisplayView::WIDTH, DisplayView::HEIGHT);
+    pVoronoiMap->setMinClearance(voronoiClearance());
+    pDisplayView->setFindMethod(pVoronoiMap);
+}
+
+qreal AppWindow::voronoiClearance()
+{
+    if (!m_ui.actionVoronoi_clearance->isChecked())
+    {
+        return 0;
+    }
+
+    // keep the device one more of its radii away from the obstacles
+    qreal radius = 0;
+    for (const QPointF& point : DisplayView::getInstance()->getDevicePolygon())
+    {
+        radius = std::max(radius, euclideanDist(QPointF(), point));
+    }
+    return radius;
+}
+
+void AppWindow::probabilisticRoadmap()
+{
+    DisplayView* pDisplayView = DisplayView::getInstance();
+    assert(pDisplayView);
+
+    setMenuActionsChecked(m_ui.menuMethod, false);
+    m_ui.actionProbabilistic_roadmap->setChecked(true);
+    pDisplayView->setFindMethod(new ProbabilisticRoadmap(DisplayView::WIDTH, DisplayView::HEIGHT));
 }
 
 void AppWindow::generate(Generate* pGenerate)
@@ -236,6 +275,50 @@ void AppWindow::useSnapping()
     pDisplayView->setUseSnapping(m_ui.actionSnapping->isChecked());
 }
 
+void AppWindow::useLazyValidation()
+{
+    if (m_ui.actionShortest_path_roadmap->isChecked())
+    {
+        shortestPathRoadmap();
+    }
+}
+
+void AppWindow::useRasterFog()
+{
+    DisplayView* pDisplayView = DisplayView::getInstance();
+    assert(pDisplayView);
+    pDisplayView->useRasterFog(m_ui.actionRaster_fog->isChecked());
+}
+
+void AppWindow::useHistorySimplification()
+{
+    DisplayView* pDisplayView = DisplayView::getInstance();
+    assert(pDisplayView);
+    pDisplayView->useHistorySimplification(m_ui.actionSimplify_history->isChecked());
+}
+
+void AppWindow::useBackgroundVision()
+{
+    DisplayView* pDisplayView = DisplayView::getInstance();
+    assert(pDisplayView);
+    pDisplayView->useBackgroundVision(m_ui.actionBackground_vision->isChecked());
+}
+
+void AppWindow::useVoronoiClearance()
+{
+    DisplayView* pDisplayView = DisplayView::getInstance();
+    assert(pDisplayView);
+
+    // the clearance only filters the built diagram, so it is kept
+    VoronoiMap* pVoronoiMap = dynamic_cast<VoronoiMap*>(pDisplayView->getFindMethod());
+    if (pVoronoiMap)
+    {
+        pDisplayView->getPathFinder()->cancel();
+        pDisplayView->getPathFinder()->wait();
+        pVoronoiMap->setMinClearance(voronoiClearance());
+    }
+}
+
 void AppWindow::about()
 {
     m_aboutDialog->show();
@@ -333,6 +416,10 @@ void AppWindow::update()
     {
         voronoiMap();
     }
+    else if (m_ui.actionProbabilistic_roadmap->isChecked())
+    {
+        probabilisticRoadmap();
+    }
 }
 
 }  // namespace Motion
\ No newline at end of file
@@ -20,9 +20,19 @@ PolygonSet ConfigurationSpace::getObstaclesMSums()
     return m_minkowskiSums;
 }
 
+std::shared_ptr<const DistanceField> ConfigurationSpace::getDistanceField(qreal cellSize)
+{
+    if (!m_pDistanceField || m_pDistanceField->cellSize() != cellSize)
+    {
+        m_pDistanceField = std::make_shared<DistanceField>(m_minkowskiSums, getSceneBBox(), cellSize);
+    }
+    return m_pDistanceField;
+}
+
 QGraphicsPolygonItem* ConfigurationSpace::addObstacle(const QPolygonF& obstacle)
 {
     m_obstacles.push_back(obstacle);
+    m_pDistanceField.reset();
 
     return update(obstacle);
 }
@@ -49,6 +59,7 @@ QGraphicsPolygonItem* ConfigurationSpace::update(const QPolygonF& polygon)
 void ConfigurationSpace::update()
 {
     m_minkowskiSums.clear();
+    m_pDistanceField.reset();
 
     for (const auto& obstacle : m_obstacles)
     {
@@ -36,9 +36,14 @@ public:
 
     void afterAnimationStep(qreal step) override
     {
-        m_pVision->update(posAt(step));
-        if (step == 1.0)
+        if (step < 1.0)
         {
+            m_pVision->update(posAt(step));
+        }
+        else
+        {
+            // the next subpath is planned from the vision at the end point
+            m_pVision->flush(posAt(step));
             DisplayView* pDisplayView = DisplayView::getInstance();
             pDisplayView->getPathFinder()->subPathReached();
         }
@@ -10,6 +10,10 @@
 namespace Motion
 {
 
+const qreal HISTORY_SIMPLIFY_TOLERANCE = 1;
+const int HISTORY_SIMPLIFY_INTERVAL = 10;
+const qreal VISION_MAX_UPDATE_RATE = 30;
+
 const QPolygonF STAR = QPolygonF({
     {0, 50},
     {10, 10},
@@ -146,6 +150,7 @@ DisplayView* DisplayView::getInstance()
 
 void DisplayView::reset(const QPolygonF& device)
 {
+    m_pPathFinder->cancel();
     m_pDevice->stopAnimation();
 
     m_pScene->clear();
@@ -175,6 +180,9 @@ void DisplayView::reset(const QPolygonF& device)
         delete m_pVision;
     }
     m_pVision = new Vision(m_pVisionGroup);
+    m_pVision->setRaster(m_bRasterFog);
+    useHistorySimplification(m_bSimplifyHistory);
+    useBackgroundVision(m_bBackgroundVision);
 
     m_pDevice = new DeviceGraphicsItem(device, m_pVision);
     m_pScene->addItem(m_pDevice);
@@ -231,6 +239,7 @@ void DisplayView::moveDevice(const Path& path)
 
 void DisplayView::reshapeDevice(const QPolygonF& polygon)
 {
+    m_pPathFinder->cancel();
     m_pDevice->reshape(polygon);
     m_configurationSpace.update();
     m_pVision->reset();
@@ -260,6 +269,7 @@ void DisplayView::undoDeviceMove()
 
 void DisplayView::addObstacle(const QPolygonF& polygon)
 {
+    m_pPathFinder->cancel();
     QGraphicsPolygonItem* pItem = m_configurationSpace.addObstacle(polygon);
     m_pObstaclesGroup->addToGroup(pItem);
 
@@ -296,6 +306,25 @@ void DisplayView::useSensors(bool bUse)
         m_pPathFinder.reset(new RegularPathFinder());
 }
 
+void DisplayView::useRasterFog(bool bUse)
+{
+    m_bRasterFog = bUse;
+    m_pVision->setRaster(bUse);
+}
+
+void DisplayView::useHistorySimplification(bool bUse)
+{
+    m_bSimplifyHistory = bUse;
+    m_pVision->setSimplification(HISTORY_SIMPLIFY_TOLERANCE, bUse ? HISTORY_SIMPLIFY_INTERVAL : 0);
+}
+
+void DisplayView::useBackgroundVision(bool bUse)
+{
+    m_bBackgroundVision = bUse;
+    m_pVision->setAsync(bUse);
+    m_pVision->setMaxUpdateRate(VISION_MAX_UPDATE_RATE);
+}
+
 Vision* DisplayView::getVision()
 {
     return m_pVision;
@@ -323,6 +352,11 @@ PolygonSet DisplayView::getObstaclesMSums()
     return m_configurationSpace.getObstaclesMSums();
 }
 
+std::shared_ptr<const DistanceField> DisplayView::getDistanceField()
+{
+    return m_configurationSpace.getDistanceField();
+}
+
 QRectF DisplayView::getViewRect()
 {
     return m_pScene->sceneRect();
@@ -347,6 +381,8 @@ void DisplayView::displayPathInfo(bool bDisplay)
 
 void DisplayView::setFindMethod(IFindMethod* pFindMethod)
 {
+    m_pPathFinder->cancel();
+    m_pPathFinder->wait();
     m_pFindMethod.reset(pFindMethod);
 }
 
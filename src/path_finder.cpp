@@ -1,13 +1,24 @@
 #include "motion/path_finder.h"
 
 #include "motion/display_view.h"
+#include "motion/algorithms/frontier.h"
 #include "motion/algorithms/utils.h"
 
 #include <QMessageBox>
 
+#include <algorithm>
+#include <cmath>
+
 namespace Motion
 {
 
+const std::chrono::milliseconds PLANNING_BUDGET(2000);
+// border points of the history polygon lie up to a 30-gon side apart
+const qreal FRONTIER_LINK_DISTANCE = 100;
+// about the vision radius, longer stretches of border are split
+const qreal FRONTIER_MAX_EXTENT = 400;
+const size_t MAX_FRONTIER_QUERIES = 5;
+
 double measureTime(std::function<void(void)> f)
 {
     auto start = std::chrono::system_clock::now();
@@ -48,6 +59,15 @@ void showNoPathFoundMessageBox(DisplayView* pDisplayView)
     );
 }
 
+void showBudgetExpiredMessageBox(DisplayView* pDisplayView)
+{
+    QMessageBox::warning(
+        pDisplayView->parentWidget(),
+        "Could not find a path",
+        "No path was found within the planning time budget."
+    );
+}
+
 void showOutOfBoundsMessageBox(DisplayView* pDisplayView)
 {
     QMessageBox::warning(
@@ -79,6 +99,25 @@ void IPathFinder::displayPath(const Path& path)
     pDisplayView->m_pPathMapGroup->addToGroup(gpath);
 }
 
+RegularPathFinder::~RegularPathFinder()
+{
+    cancel();
+    wait();
+}
+
+void RegularPathFinder::cancel()
+{
+    m_token.cancel();
+}
+
+void RegularPathFinder::wait()
+{
+    if (m_search.valid())
+    {
+        m_search.wait();
+    }
+}
+
 void RegularPathFinder::findPath(QPoint physicCoord)
 {
     DisplayView* pDisplayView = DisplayView::getInstance();
@@ -101,21 +140,77 @@ void RegularPathFinder::findPath(QPoint physicCoord)
     IFindMethod* pFindMethod = pDisplayView->getFindMethod();
     assert(pFindMethod);
 
-    Path path;
+    // The superseded query stops at its next cancellation check. The new
+    // one waits for it on the worker, so the find method never serves two
+    // queries at once and the GUI thread does not block.
+    cancel();
+    m_token = CancellationToken();
+
+    CancellationToken token = m_token;
+    // the field is cached on this thread and handed over once the find
+    // method is no longer used by the previous query
+    const auto pField = pDisplayView->getDistanceField();
+    m_search = std::async(std::launch::async, [=, previous = m_search]() mutable
+    {
+        if (previous.valid())
+        {
+            previous.wait();
+            previous = {};
+        }
+        pFindMethod->setDistanceField(pField);
+
+        FindResult result;
 
-    double elapsed = measureTime([&]() {
-        path = pFindMethod->findPath(source, destination, obstacles);
-    });
+        double elapsed = measureTime([&]() {
+            result = pFindMethod->findPath(source, destination, obstacles, deadlineAfter(PLANNING_BUDGET), token);
+        });
+
+        if (token.isCancelled())
+            return;
+
+        ShortcutStats stats;
+        if (!result.path.empty() && result.path != INVALID_PATH)
+        {
+            elapsed += measureTime([&]() {
+                result.path = shortcutPath(result.path, obstacles, 64, 8, &stats, token);
+            });
+        }
+
+        if (token.isCancelled())
+            return;
+
+        QMetaObject::invokeMethod(pDisplayView, [=]()
+        {
+            if (!token.isCancelled())
+                showResult(result, destination, elapsed, stats);
+        }, Qt::QueuedConnection);
+    }).share();
+}
+
+void RegularPathFinder::showResult(const FindResult& result, const QPointF& destination,
+                                   double elapsed, const ShortcutStats& stats)
+{
+    DisplayView* pDisplayView = DisplayView::getInstance();
+    IFindMethod* pFindMethod = pDisplayView->getFindMethod();
+
+    const Path& path = result.path;
     
     if (path.empty())
     {
-        showNoPathFoundMessageBox(pDisplayView);
+        if (result.status == FindStatus::Expired)
+            showBudgetExpiredMessageBox(pDisplayView);
+        else
+            showNoPathFoundMessageBox(pDisplayView);
         pDisplayView->clearGroup(pDisplayView->m_pPathMapGroup);
         pDisplayView->m_pPathMapGroup->addToGroup(pFindMethod->getPathMap());
         return;
     }
 
-    pDisplayView->setPathInfo(getPathInfo(path, elapsed), destination);
+    QString shortcutInfo;
+    shortcutInfo.sprintf("\nShortcutting: %4.2f units shorter, %d checks",
+                         stats.initialLength - stats.finalLength, static_cast<int>(stats.nChecks));
+
+    pDisplayView->setPathInfo(getPathInfo(path, elapsed) + shortcutInfo, destination);
     pDisplayView->moveDevice(path);
     displayPath(path);
 }
@@ -137,6 +232,7 @@ void VisionPathFinder::findPath(QPoint physicCoord)
     m_path = {};
     displayPath(m_path);
     m_visited.clear();
+    m_bFullMask = true;
 
     if (m_obstacles.inside(m_destination))
     {
@@ -158,106 +254,118 @@ void VisionPathFinder::subPathReached()
 
     if (m_pathFound)
     {
-        pDisplayView->setPathInfo(getPathInfo(m_path), m_destination);
+        QString pathInfo = getPathInfo(m_path);
+        if (!vision->getRaster())
+        {
+            QString historyInfo;
+            historyInfo.sprintf("\nExplored area vertices: %zu", vision->getHistoryVertexCount());
+            pathInfo += historyInfo;
+        }
+        pDisplayView->setPathInfo(pathInfo, m_destination);
         displayPath(m_path);
         return;
     }
     
     IFindMethod* pFindMethod = pDisplayView->getFindMethod();
     assert(pFindMethod);
+    pFindMethod->setDistanceField(pDisplayView->getDistanceField());
 
     auto obstacles = m_obstacles;
     //Polygon scene = Polygon(unclose(QPolygonF(getSceneBBox())));
     //for (const auto& p : scene.subtracted(vision->get()))
     //    obstacles.insert(p);
 
-    if (vision->getVisionHistory().inside(m_destination))
+    // between the steps the explored area only grows where the device
+    // looked, unless it was simplified; checked after the mask is copied
+    const MaskPredicate mask = vision->getExploredMask();
+    const QRectF revealed = vision->takeRevealedBounds();
+    if (vision->takeShrunk())
+        m_bFullMask = true;
+    if (m_bFullMask)
+        pFindMethod->setMask(mask);
+    else
+        pFindMethod->updateMask(mask, revealed);
+    m_bFullMask = false;
+
+    if (vision->isExplored(m_destination))
     {
-        pFindMethod->setMask(vision->getVisionHistory());
         Path path = pFindMethod->findPath(m_source, m_destination, obstacles);
+        if (!path.empty() && path != INVALID_PATH)
+            path = shortcutPath(path, obstacles);
         m_path.insert(m_path.end(), path.begin(), path.end());
         if (!path.empty() && path != INVALID_PATH)
         {
             m_pathFound = true;
-            m_visited.push_back(m_destination);
+            m_visited.insert(m_destination);
             displayPath(m_path);
             pDisplayView->moveDevice(path);
             return;
         }
     }
 
-    auto equals = [](double d1, double d2, double eps)
+    // adjacent border points form one frontier, the frontiers are handed
+    // to the planner a few at a time
+    auto frontiers = clusterFrontiers(vision->getUnknownPoints(), FRONTIER_LINK_DISTANCE, FRONTIER_MAX_EXTENT);
+    auto pos = pDisplayView->getDevicePosition();
+    auto cost = [&](const Frontier& frontier)
     {
-        return std::fabs(d1 - d2) < eps;
+        auto d1 = euclideanDistSqrd(frontier.goal, pos);
+        auto d2 = euclideanDistSqrd(frontier.goal, m_destination);
+        // larger frontiers are preferred mildly, 30 points cut the cost by a third
+        return (d1 * 0.25 + d2) / (1.0 + 0.1 * std::log2(1.0 + frontier.size));
     };
-
-    auto points = vision->getUnknownPoints();
-    auto pos = pDisplayView->getDevicePosition();
-    std::sort(points.begin(), points.end(), [&](const QPointF& p1, const QPointF& p2) {
-        auto d1 = euclideanDistSqrd(p1, pos);
-        auto d2 = euclideanDistSqrd(p2, pos);
-        auto d3 = euclideanDistSqrd(p1, m_destination);
-        auto d4 = euclideanDistSqrd(p2, m_destination);
-        //auto v1 = visited(p1);
-        //auto v2 = visited(p2);
-        //if (v1 != v2)
-        //    return v1 < v2;
-        return d1 * 0.25 + d3  < d2 * 0.25 + d4 ;
+    std::sort(frontiers.begin(), frontiers.end(), [&](const Frontier& f1, const Frontier& f2) {
+        return cost(f1) < cost(f2);
     });
-    for (const auto& point : points)
+
+    // the goals are queried in batches in rank order, one search finds the
+    // best ranked reachable goal and the goals ranked above it are dropped
+    auto next = frontiers.begin();
+    std::vector<QPointF> goals;
+    while (true)
     {
-        Polygon polygon;
-        bool valid = true;
-        QPointF shiftedPoint = point;
-        /*if (m_obstacles.inside(point, true, &polygon))
+        for (; next != frontiers.end() && goals.size() < MAX_FRONTIER_QUERIES; ++next)
         {
-            valid = false;
-            auto pts = polygon.points();
-            for (int i = 0; i < pts.size(); ++i)
-            {
-                if (vision->getVisionHistory().inside(pts[i]))
-                {
-                    if (auto pp = shifted(i, pts, polygon))
-                    {
-                        if (!valid || euclideanDist(*pp, point) < euclideanDist(shiftedPoint, point))
-                            shiftedPoint = *pp;
-                        valid = true;
-                    }
-                }
-            }
+            if (!visited(next->goal))
+                goals.push_back(next->goal);
         }
-        if (!valid)
-            continue;*/
+        if (goals.empty())
+            break;
 
-        if (visited(shiftedPoint))
+        size_t index = 0;
+        Path subPath = pFindMethod->findFirstPath(m_source, goals, obstacles, index);
+        if (subPath.empty())
+        {
+            for (const auto& goal : goals)
+                m_visited.insert(goal);
+            goals.clear();
             continue;
+        }
+
+        for (size_t i = 0; i < index; ++i)
+            m_visited.insert(goals[i]);
 
-        pFindMethod->setMask(vision->getVisionHistory());
-        Path subPath = pFindMethod->findPath(m_source, shiftedPoint, obstacles);
-        if (!subPath.empty() && subPath != INVALID_PATH && pathLength(subPath) > 0.0001)
+        if (subPath != INVALID_PATH && pathLength(subPath) > 0.0001)
         {
+            subPath = shortcutPath(subPath, obstacles);
             m_path.insert(m_path.end(), subPath.begin(), subPath.end());
-            m_visited.insert(m_visited.end(), m_path.begin(), m_path.end());
+            // earlier points of m_path were inserted on earlier steps
+            for (const auto& point : subPath)
+                m_visited.insert(point);
             displayPath(m_path);
             pDisplayView->moveDevice(subPath);
             return;
         }
-        else
-        {
-            m_visited.push_back(shiftedPoint);
-        }
+
+        m_visited.insert(goals[index]);
+        goals.erase(goals.begin(), goals.begin() + index + 1);
     }
     showNoPathFoundMessageBox(pDisplayView);
 }
 
 bool VisionPathFinder::visited(const QPointF& v)
 {
-    return std::find_if(m_visited.begin(), m_visited.end(), [&v](const QPointF& r)
-        {
-            double eps = 10;
-            return std::fabs(v.x() - r.x()) < eps &&
-                std::fabs(v.y() - r.y()) < eps;
-        }) != m_visited.end();
+    return m_visited.contains(v);
 }
 
 }  // namespace Motion
\ No newline at end of file